@@ -47,6 +47,10 @@ let package = Package(
             name: "SwiftKueryMySQL",
             dependencies: ["SwiftKuery","CMySQL"]
         ),
+        .target(
+            name: "SwiftKueryMySQLBenchmarks",
+            dependencies: ["SwiftKueryMySQL", "SwiftKuery", "CMySQL"]
+        ),
         .testTarget(
             name: "SwiftKueryMySQLTests",
             dependencies: ["SwiftKueryMySQL","CMySQL"]
@@ -39,4 +39,139 @@
 
 #endif
 
+/* Status of the *_nonblocking functions, mirroring enum net_async_status of MySQL 8.0.16 and later */
+static const int CMYSQL_ASYNC_COMPLETE = 0;
+static const int CMYSQL_ASYNC_NOT_READY = 1;
+static const int CMYSQL_ASYNC_ERROR = 2;
+static const int CMYSQL_ASYNC_COMPLETE_NO_MORE_RESULTS = 3;
+
+/* The socket of the connection, to wait for while a non-blocking call is not ready */
+static inline int cmysql_socket(MYSQL *mysql) {
+  return (int)mysql->net.fd;
+}
+
+/* Whether the server re-prepared the last executed statement with different result columns */
+static inline int cmysql_metadata_changed(MYSQL *mysql) {
+  return (mysql->server_status & SERVER_STATUS_METADATA_CHANGED) ? 1 : 0;
+}
+
+#if LIBMYSQL_VERSION_ID >= 80016
+
+  static inline int cmysql_nonblocking_supported() {
+    return 1;
+  }
+
+  static inline int cmysql_real_connect_nonblocking(MYSQL *mysql, const char *host, const char *user, const char *passwd,
+                                                    const char *db, unsigned int port, const char *unix_socket,
+                                                    unsigned long clientflag) {
+    return (int)mysql_real_connect_nonblocking(mysql, host, user, passwd, db, port, unix_socket, clientflag);
+  }
+
+  static inline int cmysql_real_query_nonblocking(MYSQL *mysql, const char *query, unsigned long length) {
+    return (int)mysql_real_query_nonblocking(mysql, query, length);
+  }
+
+  static inline int cmysql_store_result_nonblocking(MYSQL *mysql, MYSQL_RES **result) {
+    return (int)mysql_store_result_nonblocking(mysql, result);
+  }
+
+  static inline int cmysql_next_result_nonblocking(MYSQL *mysql) {
+    return (int)mysql_next_result_nonblocking(mysql);
+  }
+
+#else
+
+  static inline int cmysql_nonblocking_supported() {
+    return 0;
+  }
+
+  static inline int cmysql_real_connect_nonblocking(MYSQL *mysql, const char *host, const char *user, const char *passwd,
+                                                    const char *db, unsigned int port, const char *unix_socket,
+                                                    unsigned long clientflag) {
+    return CMYSQL_ASYNC_ERROR;
+  }
+
+  static inline int cmysql_real_query_nonblocking(MYSQL *mysql, const char *query, unsigned long length) {
+    return CMYSQL_ASYNC_ERROR;
+  }
+
+  static inline int cmysql_store_result_nonblocking(MYSQL *mysql, MYSQL_RES **result) {
+    return CMYSQL_ASYNC_ERROR;
+  }
+
+  static inline int cmysql_next_result_nonblocking(MYSQL *mysql) {
+    return CMYSQL_ASYNC_ERROR;
+  }
+
+#endif
+
+/* Protocol compression algorithms, MySQL 8.0.18 and later. Older libraries only support zlib, with MYSQL_OPT_COMPRESS */
+#if LIBMYSQL_VERSION_ID >= 80018
+
+  static inline int cmysql_set_compression_algorithms(MYSQL *mysql, const char *algorithms) {
+    return mysql_options(mysql, MYSQL_OPT_COMPRESSION_ALGORITHMS, algorithms);
+  }
+
+  static inline int cmysql_set_zstd_compression_level(MYSQL *mysql, unsigned int level) {
+    return mysql_options(mysql, MYSQL_OPT_ZSTD_COMPRESSION_LEVEL, &level);
+  }
+
+#else
+
+  static inline int cmysql_set_compression_algorithms(MYSQL *mysql, const char *algorithms) {
+    return -1;
+  }
+
+  static inline int cmysql_set_zstd_compression_level(MYSQL *mysql, unsigned int level) {
+    return -1;
+  }
+
+#endif
+
+/* TLS session resumption, MySQL 8.0.29 and later. The session data is PEM text, copied by mysql_options */
+#if LIBMYSQL_VERSION_ID >= 80029
+
+  static inline int cmysql_tls_session_supported() {
+    return 1;
+  }
+
+  static inline char *cmysql_get_tls_session(MYSQL *mysql) {
+    return (char *)mysql_get_ssl_session_data(mysql, 0, NULL);
+  }
+
+  static inline void cmysql_free_tls_session(MYSQL *mysql, char *data) {
+    mysql_free_ssl_session_data(mysql, data);
+  }
+
+  static inline int cmysql_set_tls_session(MYSQL *mysql, const char *data) {
+    return mysql_options(mysql, MYSQL_OPT_SSL_SESSION_DATA, data);
+  }
+
+  static inline int cmysql_tls_session_reused(MYSQL *mysql) {
+    return mysql_get_ssl_session_reused(mysql) ? 1 : 0;
+  }
+
+#else
+
+  static inline int cmysql_tls_session_supported() {
+    return 0;
+  }
+
+  static inline char *cmysql_get_tls_session(MYSQL *mysql) {
+    return NULL;
+  }
+
+  static inline void cmysql_free_tls_session(MYSQL *mysql, char *data) {
+  }
+
+  static inline int cmysql_set_tls_session(MYSQL *mysql, const char *data) {
+    return -1;
+  }
+
+  static inline int cmysql_tls_session_reused(MYSQL *mysql) {
+    return 0;
+  }
+
+#endif
+
 #endif
@@ -0,0 +1,128 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#if swift(>=5.5)
+#if canImport(_Concurrency)
+
+import SwiftKuery
+import Foundation
+
+@available(macOS 10.15, iOS 13, tvOS 13, watchOS 6, *)
+extension MySQLConnection {
+
+    /// Establish a connection with the database.
+    ///
+    /// - Throws: QueryError.connection if the connection could not be established.
+    public func connect() async throws {
+        let result: QueryResult = await withCheckedContinuation { continuation in
+            connect { result in
+                continuation.resume(returning: result)
+            }
+        }
+        if let error = result.asError {
+            throw error
+        }
+    }
+
+    /// Execute a raw query, without parameters it runs on the `eventLoop` of the connection if there is one.
+    ///
+    /// - Parameter raw: A String with the raw query to execute.
+    /// - Parameter parameters: An array of the parameters.
+    /// - Returns: The result of the query.
+    public func execute(_ raw: String, parameters: [Any?] = []) async -> QueryResult {
+        return await withCheckedContinuation { continuation in
+            let onCompletion: (QueryResult) -> () = { result in
+                continuation.resume(returning: result)
+            }
+            if parameters.isEmpty {
+                execute(raw, onCompletion: onCompletion)
+            } else {
+                execute(raw, parameters: parameters, onCompletion: onCompletion)
+            }
+        }
+    }
+
+    /// Execute a query, without parameters it runs on the `eventLoop` of the connection if there is one.
+    ///
+    /// - Parameter query: The query to execute.
+    /// - Parameter parameters: An array of the parameters.
+    /// - Returns: The result of the query.
+    public func execute(query: Query, parameters: [Any?] = []) async -> QueryResult {
+        return await withCheckedContinuation { continuation in
+            let onCompletion: (QueryResult) -> () = { result in
+                continuation.resume(returning: result)
+            }
+            if parameters.isEmpty {
+                execute(query: query, onCompletion: onCompletion)
+            } else {
+                execute(query: query, parameters: parameters, onCompletion: onCompletion)
+            }
+        }
+    }
+
+    /// Execute a raw query and return the `MySQLResultFetcher` of its result, whose rows can be read
+    /// as an `AsyncSequence` with `MySQLResultFetcher.batches(ofSize:prefetch:)`.
+    ///
+    /// - Parameter raw: A String with the raw query to execute.
+    /// - Parameter parameters: An optional array of the parameters.
+    /// - Returns: The fetcher of the result, or nil if the query does not return a result set.
+    /// - Throws: QueryError if the query failed.
+    public func fetch(_ raw: String, parameters: [Any?]? = nil) async throws -> MySQLResultFetcher? {
+        return try await fetching { fetch(raw, parameters: parameters, onCompletion: $0) }
+    }
+
+    /// Execute a query and return the `MySQLResultFetcher` of its result, whose rows can be read
+    /// as an `AsyncSequence` with `MySQLResultFetcher.batches(ofSize:prefetch:)`.
+    ///
+    /// - Parameter query: The query to execute.
+    /// - Parameter parameters: An optional array of the parameters.
+    /// - Returns: The fetcher of the result, or nil if the query does not return a result set.
+    /// - Throws: QueryError if the query failed.
+    public func fetch(query: Query, parameters: [Any?]? = nil) async throws -> MySQLResultFetcher? {
+        return try await fetching { fetch(query: query, parameters: parameters, onCompletion: $0) }
+    }
+
+    /// Run all the statements of a transaction in a single operation on the queue of the connection,
+    /// see `withTransaction(_:onCompletion:)`.
+    ///
+    /// - Parameter body: The function executing the statements of the transaction, committed when it returns and rolled back if it throws.
+    /// - Throws: The error thrown by `body`, or QueryError if the transaction could not be committed.
+    public func withTransaction(_ body: @escaping (MySQLTransaction) throws -> ()) async throws {
+        let result: QueryResult = await withCheckedContinuation { continuation in
+            withTransaction(body) { result in
+                continuation.resume(returning: result)
+            }
+        }
+        if let error = result.asError {
+            throw error
+        }
+    }
+
+    private func fetching(_ body: (@escaping (MySQLResultFetcher?, Error?) -> ()) -> ()) async throws -> MySQLResultFetcher? {
+        return try await withCheckedThrowingContinuation { continuation in
+            body { fetcher, error in
+                if let error = error {
+                    continuation.resume(throwing: error)
+                } else {
+                    continuation.resume(returning: fetcher)
+                }
+            }
+        }
+    }
+}
+
+#endif
+#endif
@@ -0,0 +1,230 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+
+import CMySQL
+
+/// The outcome of a `LOAD DATA LOCAL INFILE` bulk load.
+public struct MySQLBulkLoadResult {
+    /// The number of rows inserted.
+    public let rowCount: UInt64
+
+    /// The number of warnings raised by the server, for example for values that had to be truncated or converted.
+    public let warningCount: UInt32
+}
+
+/// The data sent to the server in response to the file request of a `LOAD DATA LOCAL INFILE` statement.
+///
+/// An instance is passed as user data to the callbacks registered with `mysql_set_local_infile_handler`,
+/// which are called on the thread running the statement.
+class MySQLLocalInfileSource {
+
+    /// The file name used in the statement, a request for any other file is rejected.
+    static let fileName = "SwiftKueryMySQL.rows"
+
+    private var error: String? = nil
+
+    /// Open the source, return false and set the error if it can not be read.
+    func open() -> Bool {
+        return true
+    }
+
+    /// Copy up to `count` bytes into `buffer`, returning the number copied, 0 at the end of the data or -1 on error.
+    func read(into buffer: UnsafeMutablePointer<Int8>, count: Int) -> Int {
+        return 0
+    }
+
+    func close() {
+    }
+
+    func fail(_ message: String) -> Int {
+        error = message
+        return -1
+    }
+
+    var errorMessage: String {
+        return error ?? "Error reading the rows of the bulk load"
+    }
+
+    /// Register the callbacks reading this source with `mysql`.
+    func install(on mysql: UnsafeMutablePointer<MYSQL>) {
+        let userData = Unmanaged.passUnretained(self).toOpaque()
+        mysql_set_local_infile_handler(mysql, { pointer, fileName, userData in
+            guard let pointer = pointer, let userData = userData else {
+                return 1
+            }
+            pointer.pointee = userData
+            let source = Unmanaged<MySQLLocalInfileSource>.fromOpaque(userData).takeUnretainedValue()
+            guard let fileName = fileName, String(cString: fileName) == MySQLLocalInfileSource.fileName else {
+                _ = source.fail("Rejected request for a file that is not part of the bulk load")
+                return 1
+            }
+            return source.open() ? 0 : 1
+        }, { userData, buffer, length in
+            guard let userData = userData, let buffer = buffer else {
+                return -1
+            }
+            let source = Unmanaged<MySQLLocalInfileSource>.fromOpaque(userData).takeUnretainedValue()
+            return Int32(source.read(into: buffer, count: Int(length)))
+        }, { userData in
+            guard let userData = userData else {
+                return
+            }
+            Unmanaged<MySQLLocalInfileSource>.fromOpaque(userData).takeUnretainedValue().close()
+        }, { userData, buffer, length in
+            guard let userData = userData, let buffer = buffer, length > 0 else {
+                return Int32(CR_UNKNOWN_ERROR)
+            }
+            let message = Unmanaged<MySQLLocalInfileSource>.fromOpaque(userData).takeUnretainedValue().errorMessage
+            _ = message.withCString { strncpy(buffer, $0, Int(length) - 1) }
+            buffer[Int(length) - 1] = 0
+            return Int32(CR_UNKNOWN_ERROR)
+        }, userData)
+    }
+}
+
+/// A bulk load source reading the data, already in the format expected by the statement, from an `InputStream`.
+class MySQLStreamInfileSource: MySQLLocalInfileSource {
+
+    private let stream: InputStream
+
+    init(stream: InputStream) {
+        self.stream = stream
+    }
+
+    override func open() -> Bool {
+        if stream.streamStatus == .notOpen {
+            stream.open()
+        }
+        if let error = stream.streamError {
+            return fail("Unable to open the input stream: \(error.localizedDescription)")
+        }
+        return true
+    }
+
+    override func read(into buffer: UnsafeMutablePointer<Int8>, count: Int) -> Int {
+        let read = buffer.withMemoryRebound(to: UInt8.self, capacity: count) { bytes in
+            stream.read(bytes, maxLength: count)
+        }
+        if read < 0 {
+            return fail("Error reading the input stream: \(stream.streamError?.localizedDescription ?? "unknown error")")
+        }
+        return read
+    }
+
+    override func close() {
+        stream.close()
+    }
+}
+
+/// A bulk load source serializing rows of values to tab separated lines as they are read by the server,
+/// so that no more than one buffer of serialized rows is held in memory at a time.
+class MySQLRowsInfileSource: MySQLLocalInfileSource {
+
+    private var rows: AnyIterator<[Any?]>
+    private let columnCount: Int
+    private let timeConverter: MySQLTimeConverter
+    private var pending = [UInt8]()
+    private var pendingOffset = 0
+
+    init(rows: AnyIterator<[Any?]>, columnCount: Int, timeConverter: MySQLTimeConverter) {
+        self.rows = rows
+        self.columnCount = columnCount
+        self.timeConverter = timeConverter
+    }
+
+    override func read(into buffer: UnsafeMutablePointer<Int8>, count: Int) -> Int {
+        while pending.count - pendingOffset < count, let row = rows.next() {
+            if pendingOffset > 0 {
+                pending.removeSubrange(0 ..< pendingOffset)
+                pendingOffset = 0
+            }
+            guard row.count == columnCount else {
+                return fail("Each row must have \(columnCount) values, found a row with \(row.count)")
+            }
+            append(row)
+        }
+
+        let copied = min(count, pending.count - pendingOffset)
+        guard copied > 0 else {
+            return 0
+        }
+        pending.withUnsafeBufferPointer { bytes in
+            UnsafeMutableRawPointer(buffer).copyMemory(from: bytes.baseAddress! + pendingOffset, byteCount: copied)
+        }
+        pendingOffset += copied
+        return copied
+    }
+
+    private func append(_ row: [Any?]) {
+        for (index, value) in row.enumerated() {
+            if index > 0 {
+                pending.append(UInt8(ascii: "\t"))
+            }
+            append(value)
+        }
+        pending.append(UInt8(ascii: "\n"))
+    }
+
+    private func append(_ value: Any?) {
+        switch value {
+        case nil:
+            pending.append(UInt8(ascii: "\\"))
+            pending.append(UInt8(ascii: "N"))
+        case let string as String:
+            appendEscaped(string.utf8)
+        case let data as Data:
+            appendEscaped(data)
+        case let bytes as [UInt8]:
+            appendEscaped(bytes)
+        case let bool as Bool:
+            pending.append(UInt8(ascii: bool ? "1" : "0"))
+        case let date as Date:
+            let time = timeConverter.time(from: date)
+            MySQLTimeConverter.appendDate(time, to: &pending)
+            pending.append(UInt8(ascii: " "))
+            MySQLTimeConverter.appendClock(time, to: &pending)
+        case let value?:
+            appendEscaped(String(describing: value).utf8)
+        }
+    }
+
+    /// Append the bytes of a value, escaping the characters that delimit the values and lines.
+    private func appendEscaped<C: Collection>(_ bytes: C) where C.Element == UInt8 {
+        for byte in bytes {
+            switch byte {
+            case UInt8(ascii: "\\"):
+                pending.append(UInt8(ascii: "\\"))
+                pending.append(UInt8(ascii: "\\"))
+            case UInt8(ascii: "\t"):
+                pending.append(UInt8(ascii: "\\"))
+                pending.append(UInt8(ascii: "t"))
+            case UInt8(ascii: "\n"):
+                pending.append(UInt8(ascii: "\\"))
+                pending.append(UInt8(ascii: "n"))
+            case UInt8(ascii: "\r"):
+                pending.append(UInt8(ascii: "\\"))
+                pending.append(UInt8(ascii: "r"))
+            case 0:
+                pending.append(UInt8(ascii: "\\"))
+                pending.append(UInt8(ascii: "0"))
+            default:
+                pending.append(byte)
+            }
+        }
+    }
+}
@@ -0,0 +1,265 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+
+import CMySQL
+
+/// A batch of rows of a query result, decoded column by column into typed storage.
+///
+/// Unlike the `[Any?]` rows returned by `MySQLResultFetcher.fetchNext(callback:)`, the values are not boxed:
+/// integers and floating point numbers are stored in `[Int64]` and `[Double]` arrays and the bytes of string
+/// and binary values are stored contiguously with their offsets. A batch passed back to
+/// `MySQLResultFetcher.fetchColumns(batchSize:reusing:callback:)` has its storage reused for the next rows.
+public struct MySQLColumnBatch {
+
+    /// The number of rows in the batch.
+    public internal(set) var rowCount = 0
+
+    /// The values of the columns of the batch, in the order of the columns of the result set.
+    public internal(set) var columns: [MySQLColumnValues]
+
+    init(kinds: [MySQLColumnValues.Kind]) {
+        columns = kinds.map { MySQLColumnValues(kind: $0) }
+    }
+
+    mutating func removeAll() {
+        rowCount = 0
+        for index in 0 ..< columns.count {
+            columns[index].removeAll()
+        }
+    }
+}
+
+/// The values of one column of a `MySQLColumnBatch`.
+public struct MySQLColumnValues {
+
+    /// The type of storage used for the values of a column.
+    public enum Kind {
+        /// Integer values, stored in `integers`.
+        case integer
+        /// Floating point values, stored in `reals`.
+        case real
+        /// UTF-8 encoded strings, stored in `bytes` and `offsets`. This includes DECIMAL, DATE and TIME values.
+        case text
+        /// Binary values, stored in `bytes` and `offsets`.
+        case binary
+        /// DATETIME and TIMESTAMP values, stored in `reals` as the number of seconds since 00:00:00 UTC on 1 January 1970.
+        case dateTime
+    }
+
+    /// The type of storage used for the values of the column.
+    public let kind: Kind
+
+    /// Whether the value in each row is NULL.
+    public internal(set) var nulls = [Bool]()
+
+    /// The value in each row of an `integer` column, 0 for NULL values.
+    public internal(set) var integers = [Int64]()
+
+    /// The value in each row of a `real` or `dateTime` column, 0 for NULL values.
+    public internal(set) var reals = [Double]()
+
+    /// The bytes of the values of a `text` or `binary` column. The value in row `i` is
+    /// `bytes[offsets[i] ..< offsets[i + 1]]`.
+    public internal(set) var bytes = [UInt8]()
+
+    /// The offsets of the values of a `text` or `binary` column in `bytes`, with one more element than there are rows.
+    public internal(set) var offsets = [0]
+
+    init(kind: Kind) {
+        self.kind = kind
+    }
+
+    /// Return whether the value in a row is NULL.
+    public func isNull(_ row: Int) -> Bool {
+        return nulls[row]
+    }
+
+    /// Return the value in a row of an `integer` column, or nil if it is NULL or the column is not an integer column.
+    public func integer(at row: Int) -> Int64? {
+        guard kind == .integer, !nulls[row] else {
+            return nil
+        }
+        return integers[row]
+    }
+
+    /// Return the value in a row of a `real` column, or nil if it is NULL or the column is not a real column.
+    public func double(at row: Int) -> Double? {
+        guard kind == .real, !nulls[row] else {
+            return nil
+        }
+        return reals[row]
+    }
+
+    /// Return the value in a row of a `dateTime` column, or nil if it is NULL or the column is not a dateTime column.
+    public func date(at row: Int) -> Date? {
+        guard kind == .dateTime, !nulls[row] else {
+            return nil
+        }
+        return Date(timeIntervalSince1970: reals[row])
+    }
+
+    /// Return the value in a row of a `text` column, or nil if it is NULL or the column is not a text column.
+    public func string(at row: Int) -> String? {
+        guard kind == .text, !nulls[row] else {
+            return nil
+        }
+        return String(decoding: bytes[offsets[row] ..< offsets[row + 1]], as: UTF8.self)
+    }
+
+    /// Return the value in a row of a `binary` column, or nil if it is NULL or the column is not a binary column.
+    public func data(at row: Int) -> Data? {
+        guard kind == .binary, !nulls[row] else {
+            return nil
+        }
+        return Data(bytes[offsets[row] ..< offsets[row + 1]])
+    }
+
+    mutating func removeAll() {
+        nulls.removeAll(keepingCapacity: true)
+        integers.removeAll(keepingCapacity: true)
+        reals.removeAll(keepingCapacity: true)
+        bytes.removeAll(keepingCapacity: true)
+        offsets.removeAll(keepingCapacity: true)
+        offsets.append(0)
+    }
+
+    static func kind(of type: enum_field_types, charsetnr: UInt32) -> Kind {
+        switch type {
+        case MYSQL_TYPE_TINY,
+             MYSQL_TYPE_SHORT,
+             MYSQL_TYPE_INT24,
+             MYSQL_TYPE_LONG,
+             MYSQL_TYPE_LONGLONG:
+            return .integer
+        case MYSQL_TYPE_FLOAT,
+             MYSQL_TYPE_DOUBLE:
+            return .real
+        case MYSQL_TYPE_TINY_BLOB,
+             MYSQL_TYPE_BLOB,
+             MYSQL_TYPE_MEDIUM_BLOB,
+             MYSQL_TYPE_LONG_BLOB:
+            // Value 63 is used to denote binary data
+            return charsetnr == 63 ? .binary : .text
+        case MYSQL_TYPE_BIT:
+            return .binary
+        case MYSQL_TYPE_DATETIME,
+             MYSQL_TYPE_TIMESTAMP:
+            return .dateTime
+        default:
+            return .text
+        }
+    }
+
+    /// Append the value held in the output bind of the column for the current row.
+    mutating func append(_ bind: MYSQL_BIND, length: Int, timeConverter: MySQLTimeConverter) {
+        let isNull = bind.is_null.pointee != mysql_false()
+        nulls.append(isNull)
+
+        switch kind {
+        case .integer:
+            guard !isNull else {
+                return integers.append(0)
+            }
+            switch bind.buffer_type {
+            case MYSQL_TYPE_TINY:
+                integers.append(Int64(bind.buffer.load(as: Int8.self)))
+            case MYSQL_TYPE_SHORT:
+                integers.append(Int64(bind.buffer.load(as: Int16.self)))
+            case MYSQL_TYPE_INT24,
+                 MYSQL_TYPE_LONG:
+                integers.append(Int64(bind.buffer.load(as: Int32.self)))
+            default:
+                integers.append(bind.buffer.load(as: Int64.self))
+            }
+        case .real:
+            guard !isNull else {
+                return reals.append(0)
+            }
+            if bind.buffer_type == MYSQL_TYPE_FLOAT {
+                reals.append(Double(bind.buffer.load(as: Float.self)))
+            } else {
+                reals.append(bind.buffer.load(as: Double.self))
+            }
+        case .dateTime:
+            guard !isNull, let date = timeConverter.date(from: bind.buffer.load(as: MYSQL_TIME.self)) else {
+                nulls[nulls.count - 1] = true
+                return reals.append(0)
+            }
+            reals.append(date.timeIntervalSince1970)
+        case .text,
+             .binary:
+            if !isNull {
+                switch bind.buffer_type {
+                case MYSQL_TYPE_TIME:
+                    MySQLTimeConverter.appendTime(bind.buffer.load(as: MYSQL_TIME.self), to: &bytes)
+                case MYSQL_TYPE_DATE:
+                    MySQLTimeConverter.appendDate(bind.buffer.load(as: MYSQL_TIME.self), to: &bytes)
+                default:
+                    bytes.append(contentsOf: UnsafeRawBufferPointer(start: bind.buffer, count: length))
+                }
+            }
+            offsets.append(bytes.count)
+        }
+    }
+
+    /// Append a value of a column streamed with `MySQLResultFetcher.stream(column:chunkSize:to:)`,
+    /// which is the length of the value or nil if it was NULL.
+    mutating func append(streamedLength length: Int?) {
+        nulls.append(length == nil)
+        integers.append(Int64(length ?? 0))
+    }
+
+    /// Append a value that has already been decoded by `MySQLResultFetcher`.
+    ///
+    /// - Parameter scale: The number of decimals of the column, with which DECIMAL values decoded as scaled integers are written.
+    mutating func append(value: Any?, scale: Int = 0) {
+        nulls.append(value == nil)
+        switch kind {
+        case .integer:
+            switch value {
+            case let int as Int8: integers.append(Int64(int))
+            case let int as Int16: integers.append(Int64(int))
+            case let int as Int32: integers.append(Int64(int))
+            case let int as Int64: integers.append(int)
+            case let int as Int: integers.append(Int64(int))
+            default: integers.append(0)
+            }
+        case .real:
+            switch value {
+            case let float as Float: reals.append(Double(float))
+            case let double as Double: reals.append(double)
+            default: reals.append(0)
+            }
+        case .dateTime:
+            reals.append((value as? Date)?.timeIntervalSince1970 ?? 0)
+        case .text,
+             .binary:
+            switch value {
+            case let string as String: bytes.append(contentsOf: string.utf8)
+            case let data as Data: bytes.append(contentsOf: data)
+            case let date as MySQLDate: bytes.append(contentsOf: date.description.utf8)
+            case let time as MySQLTime: bytes.append(contentsOf: time.description.utf8)
+            // DECIMAL values, depending on the `decimals` option
+            case let decimal as Decimal: bytes.append(contentsOf: decimal.description.utf8)
+            case let int as Int64: MySQLDecimalConverter.appendText(ofScaled: int, scale: scale, to: &bytes)
+            default: break
+            }
+            offsets.append(bytes.count)
+        }
+    }
+}
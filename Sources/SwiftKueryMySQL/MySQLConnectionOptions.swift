@@ -0,0 +1,101 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+
+/// A compression algorithm of the client/server protocol.
+public enum MySQLCompressionAlgorithm: String {
+    /// zstd compression, supported by MySQL 8.0.18 and later.
+    case zstd
+    /// zlib compression, supported by all versions.
+    case zlib
+    /// No compression, to permit uncompressed connections to servers that support none of the other algorithms.
+    case uncompressed
+}
+
+/// The options of the network connection of a `MySQLConnection` to the server.
+public struct MySQLConnectionOptions {
+
+    /// The compression algorithms permitted for the connection, in order of preference, used to set
+    /// `MYSQL_OPT_COMPRESSION_ALGORITHMS`. Empty, the default, leaves the connection uncompressed.
+    /// With client libraries older than MySQL 8.0.18 only zlib is available, enabled with `MYSQL_OPT_COMPRESS`.
+    public var compression: [MySQLCompressionAlgorithm]
+
+    /// The zstd compression level from 1 to 22, used to set `MYSQL_OPT_ZSTD_COMPRESSION_LEVEL`.
+    /// When nil, the default level of the client library, 3, is used.
+    public var zstdCompressionLevel: Int?
+
+    /// The timeout in seconds of each attempt to read from the server, used to set `MYSQL_OPT_READ_TIMEOUT`.
+    /// The client library retries a read that times out twice. When nil, reads do not time out.
+    public var readTimeout: TimeInterval?
+
+    /// The timeout in seconds of each attempt to write to the server, used to set `MYSQL_OPT_WRITE_TIMEOUT`.
+    /// When nil, writes do not time out.
+    public var writeTimeout: TimeInterval?
+
+    /// Whether connections resume the TLS session of an earlier connection, with `MYSQL_OPT_SSL_SESSION_DATA`,
+    /// which saves a full TLS handshake when opening the connections of a pool or reconnecting.
+    /// The connections of a pool share the session of the first of them. This requires MySQL 8.0.29 or later
+    /// and has no effect on connections that do not use TLS.
+    public var reuseTLSSessions: Bool
+
+    /// SQL statements the server executes when the connection is established, and again when the client library
+    /// reconnects, set with `MYSQL_INIT_COMMAND` so that they run during the connect instead of in separate round trips.
+    /// Typically `SET` statements of session variables. A failing statement fails the connect. Defaults to none.
+    public var initCommands: [String]
+
+    /// Initialize an instance of MySQLConnectionOptions.
+    ///
+    /// - Parameter compression: The compression algorithms permitted for the connection, in order of preference.
+    /// - Parameter zstdCompressionLevel: The zstd compression level from 1 to 22, or nil for the default.
+    /// - Parameter readTimeout: The timeout in seconds of reads from the server, or nil for none.
+    /// - Parameter writeTimeout: The timeout in seconds of writes to the server, or nil for none.
+    /// - Parameter reuseTLSSessions: Whether connections resume the TLS session of an earlier connection.
+    /// - Parameter initCommands: SQL statements the server executes when the connection is established.
+    public init(compression: [MySQLCompressionAlgorithm] = [], zstdCompressionLevel: Int? = nil, readTimeout: TimeInterval? = nil, writeTimeout: TimeInterval? = nil, reuseTLSSessions: Bool = true, initCommands: [String] = []) {
+        self.compression = compression
+        self.zstdCompressionLevel = zstdCompressionLevel
+        self.readTimeout = readTimeout
+        self.writeTimeout = writeTimeout
+        self.reuseTLSSessions = reuseTLSSessions
+        self.initCommands = initCommands
+    }
+
+    /// A timeout in whole seconds, as taken by the client library, rounded up so that it is never 0.
+    static func seconds(_ timeout: TimeInterval) -> UInt32 {
+        return UInt32(min(max(timeout.rounded(.up), 1), Double(UInt32.max)))
+    }
+}
+
+/// The TLS session resumed by new connections, shared by the connections of a pool.
+final class MySQLTLSSessionCache {
+    private let lock = NSLock()
+    private var _session: String? = nil
+
+    /// The serialized session, as returned by `mysql_get_ssl_session_data`.
+    var session: String? {
+        get {
+            lock.lock()
+            defer { lock.unlock() }
+            return _session
+        }
+        set {
+            lock.lock()
+            _session = newValue
+            lock.unlock()
+        }
+    }
+}
@@ -0,0 +1,282 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+
+import CMySQL
+
+/// Options controlling how MySQL date, time and DECIMAL values are converted to and from Swift values.
+public struct MySQLTypeOptions {
+
+    /// The time zone DATETIME and TIMESTAMP values are interpreted in when they are converted to and from `Date`,
+    /// defaults to the current time zone.
+    public var timeZone: TimeZone
+
+    /// Whether DATE and TIME values are returned as `MySQLDate` and `MySQLTime` instead of `String`, defaults to false.
+    public var dateAndTimeAsValueTypes: Bool
+
+    /// The type DECIMAL values are returned as, defaults to `String`. `Decimal` values bound as parameters
+    /// are always sent as DECIMAL.
+    public var decimals: MySQLDecimalDecoding
+
+    /// Initialize an instance of MySQLTypeOptions.
+    ///
+    /// - Parameter timeZone: The time zone DATETIME and TIMESTAMP values are interpreted in.
+    /// - Parameter dateAndTimeAsValueTypes: Whether DATE and TIME values are returned as `MySQLDate` and `MySQLTime`.
+    /// - Parameter decimals: The type DECIMAL values are returned as.
+    public init(timeZone: TimeZone = .current, dateAndTimeAsValueTypes: Bool = false, decimals: MySQLDecimalDecoding = .string) {
+        self.timeZone = timeZone
+        self.dateAndTimeAsValueTypes = dateAndTimeAsValueTypes
+        self.decimals = decimals
+    }
+}
+
+/// A MySQL DATE value.
+public struct MySQLDate: Equatable, CustomStringConvertible {
+    public var year: Int
+    public var month: Int
+    public var day: Int
+
+    public init(year: Int, month: Int, day: Int) {
+        self.year = year
+        self.month = month
+        self.day = day
+    }
+
+    init(_ time: MYSQL_TIME) {
+        self.init(year: Int(time.year), month: Int(time.month), day: Int(time.day))
+    }
+
+    /// The date in the format yyyy-MM-dd.
+    public var description: String {
+        var bytes = [UInt8]()
+        MySQLTimeConverter.appendDate(mysqlTime, to: &bytes)
+        return String(decoding: bytes, as: UTF8.self)
+    }
+
+    var mysqlTime: MYSQL_TIME {
+        var time = MYSQL_TIME()
+        time.year = UInt32(clamping: year)
+        time.month = UInt32(clamping: month)
+        time.day = UInt32(clamping: day)
+        time.time_type = MYSQL_TIMESTAMP_DATE
+        return time
+    }
+}
+
+/// A MySQL TIME value, which is a time of day or an elapsed time of up to 838 hours.
+public struct MySQLTime: Equatable, CustomStringConvertible {
+    public var isNegative: Bool
+    public var hours: Int
+    public var minutes: Int
+    public var seconds: Int
+    public var microseconds: Int
+
+    public init(hours: Int, minutes: Int, seconds: Int, microseconds: Int = 0, isNegative: Bool = false) {
+        self.hours = hours
+        self.minutes = minutes
+        self.seconds = seconds
+        self.microseconds = microseconds
+        self.isNegative = isNegative
+    }
+
+    init(_ time: MYSQL_TIME) {
+        self.init(hours: Int(time.day) * 24 + Int(time.hour), minutes: Int(time.minute), seconds: Int(time.second),
+                  microseconds: Int(time.second_part), isNegative: time.neg != mysql_false())
+    }
+
+    /// The time in the format HH:mm:ss, followed by the microseconds if there are any.
+    public var description: String {
+        var bytes = [UInt8]()
+        MySQLTimeConverter.appendTime(mysqlTime, to: &bytes)
+        if microseconds > 0 {
+            bytes.append(UInt8(ascii: "."))
+            MySQLTimeConverter.appendDigits(UInt32(clamping: microseconds), minimumCount: 6, to: &bytes)
+        }
+        return String(decoding: bytes, as: UTF8.self)
+    }
+
+    var mysqlTime: MYSQL_TIME {
+        var time = MYSQL_TIME()
+        time.hour = UInt32(clamping: hours)
+        time.minute = UInt32(clamping: minutes)
+        time.second = UInt32(clamping: seconds)
+        time.second_part = UInt(clamping: microseconds)
+        time.neg = isNegative ? mysql_true() : mysql_false()
+        time.time_type = MYSQL_TIMESTAMP_TIME
+        return time
+    }
+}
+
+/// Converts between `MYSQL_TIME` and `Date` in a time zone with calendar arithmetic,
+/// avoiding the string round trip and the shared state of a `DateFormatter`.
+struct MySQLTimeConverter {
+
+    private static let secondsPerDay = 86_400
+
+    let timeZone: TimeZone
+
+    /// The offset from GMT of the time zone if it does not observe daylight saving time.
+    private let fixedOffset: Int?
+
+    init(timeZone: TimeZone) {
+        self.timeZone = timeZone
+        let offset = timeZone.secondsFromGMT()
+        if timeZone.nextDaylightSavingTimeTransition == nil && timeZone.secondsFromGMT(for: Date.distantPast) == offset {
+            fixedOffset = offset
+        } else {
+            fixedOffset = nil
+        }
+    }
+
+    /// Return the `Date` of a DATETIME or TIMESTAMP value in the time zone, or nil for a zero date.
+    func date(from time: MYSQL_TIME) -> Date? {
+        guard time.month > 0 && time.day > 0 else {
+            return nil
+        }
+        let days = MySQLTimeConverter.days(year: Int(time.year), month: Int(time.month), day: Int(time.day))
+        let localSeconds = days * MySQLTimeConverter.secondsPerDay + Int(time.hour) * 3600 + Int(time.minute) * 60 + Int(time.second)
+        let seconds = localSeconds - offset(forLocalSeconds: localSeconds)
+        return Date(timeIntervalSince1970: Double(seconds) + Double(time.second_part) / 1_000_000)
+    }
+
+    /// Return the `MYSQL_TIME` of a `Date` in the time zone, truncated to whole seconds.
+    ///
+    /// - Parameter type: MYSQL_TYPE_DATE or MYSQL_TYPE_TIME to keep only the date or time of day, otherwise both are kept.
+    func time(from date: Date, type: enum_field_types = MYSQL_TYPE_DATETIME) -> MYSQL_TIME {
+        let seconds = Int(date.timeIntervalSince1970.rounded(.down))
+        let localSeconds = seconds + (fixedOffset ?? timeZone.secondsFromGMT(for: date))
+        let days = floorDivide(localSeconds, MySQLTimeConverter.secondsPerDay)
+        let secondOfDay = localSeconds - days * MySQLTimeConverter.secondsPerDay
+
+        var time = MYSQL_TIME()
+        if type != MYSQL_TYPE_TIME {
+            let civil = MySQLTimeConverter.civil(days: days)
+            time.year = UInt32(clamping: civil.year)
+            time.month = UInt32(civil.month)
+            time.day = UInt32(civil.day)
+        }
+        if type != MYSQL_TYPE_DATE {
+            time.hour = UInt32(secondOfDay / 3600)
+            time.minute = UInt32(secondOfDay / 60 % 60)
+            time.second = UInt32(secondOfDay % 60)
+        }
+        switch type {
+        case MYSQL_TYPE_DATE:
+            time.time_type = MYSQL_TIMESTAMP_DATE
+        case MYSQL_TYPE_TIME:
+            time.time_type = MYSQL_TIMESTAMP_TIME
+        default:
+            time.time_type = MYSQL_TIMESTAMP_DATETIME
+        }
+        return time
+    }
+
+    private func offset(forLocalSeconds localSeconds: Int) -> Int {
+        if let fixedOffset = fixedOffset {
+            return fixedOffset
+        }
+        // The offset at the local time read as GMT is off by at most the daylight saving shift, correct it once
+        let guess = timeZone.secondsFromGMT(for: Date(timeIntervalSince1970: Double(localSeconds)))
+        return timeZone.secondsFromGMT(for: Date(timeIntervalSince1970: Double(localSeconds - guess)))
+    }
+
+    private func floorDivide(_ value: Int, _ divisor: Int) -> Int {
+        return value >= 0 ? value / divisor : (value - divisor + 1) / divisor
+    }
+
+    /// The number of days since 1970-01-01 of a date in the proleptic Gregorian calendar.
+    static func days(year: Int, month: Int, day: Int) -> Int {
+        let y = month <= 2 ? year - 1 : year
+        let era = (y >= 0 ? y : y - 399) / 400
+        let yearOfEra = y - era * 400
+        let dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1
+        let dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear
+        return era * 146_097 + dayOfEra - 719_468
+    }
+
+    /// The date in the proleptic Gregorian calendar of a number of days since 1970-01-01.
+    static func civil(days: Int) -> (year: Int, month: Int, day: Int) {
+        let z = days + 719_468
+        let era = (z >= 0 ? z : z - 146_096) / 146_097
+        let dayOfEra = z - era * 146_097
+        let yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36_524 - dayOfEra / 146_096) / 365
+        let dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100)
+        let shiftedMonth = (5 * dayOfYear + 2) / 153
+        let day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1
+        let month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9
+        return (yearOfEra + era * 400 + (month <= 2 ? 1 : 0), month, day)
+    }
+
+    /// Return a DATE value in the format yyyy-MM-dd.
+    static func dateString(_ time: MYSQL_TIME) -> String {
+        var bytes = [UInt8]()
+        bytes.reserveCapacity(10)
+        appendDate(time, to: &bytes)
+        return String(decoding: bytes, as: UTF8.self)
+    }
+
+    /// Return a TIME value in the format HH:mm:ss.
+    static func timeString(_ time: MYSQL_TIME) -> String {
+        var bytes = [UInt8]()
+        bytes.reserveCapacity(9)
+        appendTime(time, to: &bytes)
+        return String(decoding: bytes, as: UTF8.self)
+    }
+
+    static func appendDate(_ time: MYSQL_TIME, to bytes: inout [UInt8]) {
+        appendDigits(time.year, minimumCount: 1, to: &bytes)
+        bytes.append(UInt8(ascii: "-"))
+        appendDigits(time.month, minimumCount: 2, to: &bytes)
+        bytes.append(UInt8(ascii: "-"))
+        appendDigits(time.day, minimumCount: 2, to: &bytes)
+    }
+
+    static func appendTime(_ time: MYSQL_TIME, to bytes: inout [UInt8]) {
+        if time.neg != mysql_false() {
+            bytes.append(UInt8(ascii: "-"))
+        }
+        // Times longer than a day are returned with the whole days in `day` by some client versions
+        appendDigits(time.day * 24 + time.hour, minimumCount: 2, to: &bytes)
+        appendMinutesAndSeconds(time, to: &bytes)
+    }
+
+    /// Append the time of day of a DATETIME value in the format HH:mm:ss, where `day` is the day of the month.
+    static func appendClock(_ time: MYSQL_TIME, to bytes: inout [UInt8]) {
+        appendDigits(time.hour, minimumCount: 2, to: &bytes)
+        appendMinutesAndSeconds(time, to: &bytes)
+    }
+
+    private static func appendMinutesAndSeconds(_ time: MYSQL_TIME, to bytes: inout [UInt8]) {
+        bytes.append(UInt8(ascii: ":"))
+        appendDigits(time.minute, minimumCount: 2, to: &bytes)
+        bytes.append(UInt8(ascii: ":"))
+        appendDigits(time.second, minimumCount: 2, to: &bytes)
+    }
+
+    static func appendDigits(_ value: UInt32, minimumCount: Int, to bytes: inout [UInt8]) {
+        var divisor: UInt32 = 1
+        var count = 1
+        while count < minimumCount || value / divisor >= 10 {
+            divisor *= 10
+            count += 1
+        }
+        while divisor > 0 {
+            bytes.append(UInt8(ascii: "0") + UInt8((value / divisor) % 10))
+            divisor /= 10
+        }
+    }
+}
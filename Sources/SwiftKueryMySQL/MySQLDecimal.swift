@@ -0,0 +1,155 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+
+/// The type DECIMAL values are returned as.
+public enum MySQLDecimalDecoding {
+    /// DECIMAL values are returned as `String`, the default.
+    case string
+
+    /// DECIMAL values are returned as `Decimal`.
+    case decimal
+
+    /// DECIMAL values are returned as `Int64` values scaled by 10 to the power of the scale of the column,
+    /// so that 12.34 in a DECIMAL(10,2) column is returned as 1234. Values that do not fit in an `Int64`
+    /// are returned as `Decimal`.
+    case scaledInteger
+}
+
+/// Decoding of the text of DECIMAL values, which is how both the text and the binary protocols transfer them.
+/// The digits are accumulated directly from the bytes of the value, and without a locale, instead of creating
+/// a `String` and parsing it.
+struct MySQLDecimalConverter {
+
+    /// Used to parse values with more digits than fit in a UInt64.
+    private static let posixLocale = Locale(identifier: "en_US_POSIX")
+
+    /// Decode a DECIMAL value.
+    ///
+    /// - Parameter bytes: The text of the value, such as -123.45.
+    /// - Parameter decoding: The type to decode the value to.
+    /// - Parameter scale: The number of decimals of the column.
+    /// - Returns: The value, or nil if the text is not a decimal number.
+    static func decode(_ bytes: UnsafeBufferPointer<UInt8>, as decoding: MySQLDecimalDecoding, scale: Int) -> Any? {
+        switch decoding {
+        case .string:
+            return String(decoding: bytes, as: UTF8.self)
+        case .decimal:
+            return decimal(bytes)
+        case .scaledInteger:
+            if let value = scaledInteger(bytes, scale: scale) {
+                return value
+            }
+            return decimal(bytes)
+        }
+    }
+
+    /// Decode a DECIMAL value to a `Decimal`.
+    static func decimal(_ bytes: UnsafeBufferPointer<UInt8>) -> Decimal? {
+        guard let parsed = parse(bytes) else {
+            return nil
+        }
+        guard let significand = parsed.significand else {
+            // DECIMAL has up to 65 digits, more than fit in a UInt64
+            return Decimal(string: String(decoding: bytes, as: UTF8.self), locale: posixLocale)
+        }
+        // A negative zero would be NaN
+        let sign: FloatingPointSign = parsed.isNegative && significand != 0 ? .minus : .plus
+        return Decimal(sign: sign, exponent: -parsed.fractionDigits, significand: Decimal(significand))
+    }
+
+    /// Decode a DECIMAL value to an `Int64` scaled by 10 to the power of `scale`.
+    ///
+    /// - Returns: The scaled value, or nil if it does not fit in an `Int64`.
+    static func scaledInteger(_ bytes: UnsafeBufferPointer<UInt8>, scale: Int) -> Int64? {
+        guard let parsed = parse(bytes), var significand = parsed.significand, parsed.fractionDigits <= scale else {
+            return nil
+        }
+        for _ in parsed.fractionDigits ..< scale {
+            let (scaled, overflow) = significand.multipliedReportingOverflow(by: 10)
+            guard !overflow else {
+                return nil
+            }
+            significand = scaled
+        }
+        if parsed.isNegative {
+            guard significand <= UInt64(Int64.max) + 1 else {
+                return nil
+            }
+            return significand == UInt64(Int64.max) + 1 ? Int64.min : -Int64(significand)
+        }
+        guard significand <= UInt64(Int64.max) else {
+            return nil
+        }
+        return Int64(significand)
+    }
+
+    /// Append the text of a value decoded with `scaledInteger(_:scale:)`, such as 12.34 for 1234 with a scale of 2.
+    static func appendText(ofScaled value: Int64, scale: Int, to bytes: inout [UInt8]) {
+        if value < 0 {
+            bytes.append(UInt8(ascii: "-"))
+        }
+        var digits = Array(String(value.magnitude).utf8)
+        if scale > 0 {
+            if digits.count <= scale {
+                digits.insert(contentsOf: repeatElement(UInt8(ascii: "0"), count: scale - digits.count + 1), at: 0)
+            }
+            digits.insert(UInt8(ascii: "."), at: digits.count - scale)
+        }
+        bytes.append(contentsOf: digits)
+    }
+
+    /// Split the text of a value into its sign, its digits as an integer, which is nil when they
+    /// do not fit in a UInt64, and the number of digits after the decimal point.
+    private static func parse(_ bytes: UnsafeBufferPointer<UInt8>) -> (isNegative: Bool, significand: UInt64?, fractionDigits: Int)? {
+        var index = 0
+        var isNegative = false
+        if index < bytes.count && (bytes[index] == UInt8(ascii: "-") || bytes[index] == UInt8(ascii: "+")) {
+            isNegative = bytes[index] == UInt8(ascii: "-")
+            index += 1
+        }
+
+        var significand: UInt64? = 0
+        var digits = 0
+        var fractionDigits = 0
+        var inFraction = false
+        while index < bytes.count {
+            let byte = bytes[index]
+            index += 1
+            if byte == UInt8(ascii: ".") && !inFraction {
+                inFraction = true
+                continue
+            }
+            guard byte >= UInt8(ascii: "0") && byte <= UInt8(ascii: "9") else {
+                return nil
+            }
+            digits += 1
+            if inFraction {
+                fractionDigits += 1
+            }
+            if let value = significand {
+                let (shifted, overflow) = value.multipliedReportingOverflow(by: 10)
+                let (sum, carry) = shifted.addingReportingOverflow(UInt64(byte - UInt8(ascii: "0")))
+                significand = overflow || carry ? nil : sum
+            }
+        }
+        guard digits > 0 else {
+            return nil
+        }
+        return (isNegative, significand, fractionDigits)
+    }
+}
@@ -0,0 +1,228 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+import Dispatch
+
+import CMySQL
+
+/// An event loop driving the non-blocking functions of libmysqlclient for any number of connections.
+///
+/// When a `MySQLEventLoop` is set as the `eventLoop` of a `MySQLConnection`, connecting and executing queries
+/// without parameters do not park a thread while waiting for the server: each non-blocking call that is not ready
+/// is resumed from a `DispatchSource` watching the socket of the connection, on the single serial queue of the loop.
+/// Many connections can share one event loop.
+///
+/// The non-blocking functions were introduced in MySQL 8.0.16. With older client libraries, `isSupported` is false
+/// and connections ignore their event loop. libmysqlclient has no non-blocking prepared statement functions, so
+/// queries with parameters and prepared statements always run on the queue of the connection.
+public final class MySQLEventLoop {
+
+    /// Whether the client library provides the non-blocking functions.
+    public static var isSupported: Bool {
+        return cmysql_nonblocking_supported() != 0
+    }
+
+    /// The longest wait for the socket before a call that is not ready is retried, in case it was waiting
+    /// in the other direction than the one watched.
+    fileprivate static let retryInterval = DispatchTimeInterval.milliseconds(100)
+
+    /// The interval at which a call is retried while the connection has no socket to watch yet.
+    private static let socketRetryInterval = DispatchTimeInterval.milliseconds(10)
+
+    let queue: DispatchQueue
+
+    /// Initialize an instance of MySQLEventLoop.
+    ///
+    /// - Parameter label: The label of the serial queue of the event loop.
+    public init(label: String = "SwiftKueryMySQL.eventLoop") {
+        queue = DispatchQueue(label: label)
+    }
+
+    /// Call `step` on the event loop until it no longer returns `CMYSQL_ASYNC_NOT_READY`, then call `completion`
+    /// with its final status on the event loop.
+    ///
+    /// - Parameter mysql: The connection whose socket `step` waits for.
+    /// - Parameter step: A call to a non-blocking function.
+    /// - Parameter completion: The function to be called with the final status.
+    func drive(_ mysql: UnsafeMutablePointer<MYSQL>, step: @escaping () -> Int32, completion: @escaping (Int32) -> ()) {
+        queue.async {
+            self.poll(mysql, watcher: nil, step: step, completion: completion)
+        }
+    }
+
+    private func poll(_ mysql: UnsafeMutablePointer<MYSQL>, watcher: SocketWatcher?, step: @escaping () -> Int32, completion: @escaping (Int32) -> ()) {
+        MySQLThread.initialize()
+        let status = step()
+        guard status == CMYSQL_ASYNC_NOT_READY else {
+            // The sources are cancelled before the completion, which may close the socket
+            guard let watcher = watcher else {
+                return completion(status)
+            }
+            return watcher.cancel {
+                completion(status)
+            }
+        }
+
+        // The socket is created, and may be replaced, by the first steps of a connect
+        let socket = cmysql_socket(mysql)
+        var current = watcher
+        if let watcher = watcher, watcher.socket != socket {
+            watcher.cancel {}
+            current = nil
+        }
+        if current == nil && socket >= 0 {
+            current = SocketWatcher(socket: socket, queue: queue)
+        }
+        guard let socketWatcher = current else {
+            queue.asyncAfter(deadline: .now() + MySQLEventLoop.socketRetryInterval) {
+                self.poll(mysql, watcher: nil, step: step, completion: completion)
+            }
+            return
+        }
+        socketWatcher.wait {
+            self.poll(mysql, watcher: socketWatcher, step: step, completion: completion)
+        }
+    }
+}
+
+/// Watches the socket of a connection while a non-blocking call is not ready. The read and write sources and the
+/// retry timer are created once for the call and suspended between its waits.
+///
+/// libmysqlclient does not report whether a call is waiting to read or to write, so a wait watches for the socket to
+/// become writable when it is not, as the call can only be blocked writing then, and to become readable otherwise.
+private final class SocketWatcher {
+    let socket: Int32
+    private let queue: DispatchQueue
+    private var readSource: DispatchSourceRead?
+    private var writeSource: DispatchSourceWrite?
+    private var timer: DispatchSourceTimer?
+    private var onReady: (() -> ())?
+
+    /// The source resumed for the current wait, the others are suspended.
+    private enum Direction {
+        case none
+        case read
+        case write
+    }
+    private var waiting = Direction.none
+
+    init(socket: Int32, queue: DispatchQueue) {
+        self.socket = socket
+        self.queue = queue
+    }
+
+    /// Call `onReady` on the queue once the socket is ready, or the retry interval has passed.
+    func wait(onReady: @escaping () -> ()) {
+        self.onReady = onReady
+        if isWritable() {
+            read().resume()
+            waiting = .read
+        } else {
+            write().resume()
+            waiting = .write
+        }
+        retryTimer().schedule(deadline: .now() + MySQLEventLoop.retryInterval)
+    }
+
+    /// Cancel the sources, calling `completion` on the queue once they no longer use the socket.
+    func cancel(completion: @escaping () -> ()) {
+        onReady = nil
+        let group = DispatchGroup()
+        let sources: [DispatchSourceProtocol?] = [readSource, writeSource, timer]
+        for case let source? in sources {
+            group.enter()
+            source.setCancelHandler {
+                group.leave()
+            }
+            source.cancel()
+        }
+        // A suspended source only runs its cancel handler once it is resumed
+        if waiting != .read {
+            readSource?.resume()
+        }
+        if waiting != .write {
+            writeSource?.resume()
+        }
+        waiting = .none
+        readSource = nil
+        writeSource = nil
+        timer = nil
+        group.notify(queue: queue, execute: completion)
+    }
+
+    private func ready() {
+        guard let onReady = onReady else {
+            return
+        }
+        self.onReady = nil
+        switch waiting {
+        case .read:
+            readSource?.suspend()
+        case .write:
+            writeSource?.suspend()
+        case .none:
+            break
+        }
+        waiting = .none
+        timer?.schedule(deadline: .distantFuture)
+        onReady()
+    }
+
+    private func read() -> DispatchSourceRead {
+        if let source = readSource {
+            return source
+        }
+        let source = DispatchSource.makeReadSource(fileDescriptor: socket, queue: queue)
+        source.setEventHandler { [weak self] in
+            self?.ready()
+        }
+        readSource = source
+        return source
+    }
+
+    private func write() -> DispatchSourceWrite {
+        if let source = writeSource {
+            return source
+        }
+        let source = DispatchSource.makeWriteSource(fileDescriptor: socket, queue: queue)
+        source.setEventHandler { [weak self] in
+            self?.ready()
+        }
+        writeSource = source
+        return source
+    }
+
+    private func retryTimer() -> DispatchSourceTimer {
+        if let timer = timer {
+            return timer
+        }
+        let timer = DispatchSource.makeTimerSource(queue: queue)
+        timer.schedule(deadline: .distantFuture)
+        timer.setEventHandler { [weak self] in
+            self?.ready()
+        }
+        timer.resume()
+        self.timer = timer
+        return timer
+    }
+
+    /// Whether the socket can be written to without blocking.
+    private func isWritable() -> Bool {
+        var descriptor = pollfd(fd: socket, events: Int16(POLLOUT), revents: 0)
+        return poll(&descriptor, 1, 0) > 0 && descriptor.revents & Int16(POLLOUT) != 0
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import SwiftKuery
+
+/// A query result fetcher for rows that are already held in memory, such as the IDs generated by an insert.
+class MySQLInMemoryResultFetcher: ResultFetcher {
+
+    private let titles: [String]
+    private var rows: IndexingIterator<[[Any?]]>
+    private var preparedStatement: MySQLPreparedStatement?
+
+    /// Initialize an instance of MySQLInMemoryResultFetcher.
+    ///
+    /// - Parameter titles: The column titles.
+    /// - Parameter rows: The rows of the result.
+    /// - Parameter preparedStatement: The statement that produced the rows, released when the fetcher is done.
+    init(titles: [String], rows: [[Any?]], preparedStatement: MySQLPreparedStatement? = nil) {
+        self.titles = titles
+        self.rows = rows.makeIterator()
+        self.preparedStatement = preparedStatement
+    }
+
+    deinit {
+        done()
+    }
+
+    /// Indicate no further calls will be made to this ResultFetcher allowing the statement in use to be released.
+    public func done() {
+        rows = [].makeIterator()
+        if let preparedStatement = preparedStatement {
+            self.preparedStatement = nil
+            preparedStatement.release { _ in }
+        }
+    }
+
+    /// Fetch the next row of the query result.
+    ///
+    /// - Parameter callback: A callback to call when the next row of the query result is ready.
+    public func fetchNext(callback: @escaping (([Any?]?, Error?)) -> ()) {
+        guard let row = rows.next() else {
+            done()
+            return callback((nil, nil))
+        }
+        callback((row, nil))
+    }
+
+    /// Fetch the titles of the query result.
+    ///
+    /// - Parameter callback: A closure that accepts a tuple containing an optional array of column titles of type String and an optional Error
+    public func fetchTitles(callback: @escaping (([String]?, Error?)) -> ()) {
+        callback((titles, nil))
+    }
+}
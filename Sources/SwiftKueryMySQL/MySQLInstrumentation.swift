@@ -0,0 +1,168 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+import Dispatch
+
+import SwiftKuery
+
+/// Receives timings and counters of the work done by connections, for example to record them with swift-metrics.
+///
+/// Set an instrumentation as the `instrumentation` of a connection, or pass it to `MySQLConnection.createPool`.
+/// The functions are called on the queue of the connection, so they should return quickly. Nothing is measured
+/// for connections without an instrumentation.
+public protocol MySQLInstrumentation: AnyObject {
+
+    /// Called when a prepared statement has been executed.
+    func didExecute(_ metrics: MySQLStatementMetrics)
+
+    /// Called when the rows of a result set have been fetched, or the result set was closed before the last row.
+    func didFetch(_ metrics: MySQLFetchMetrics)
+
+    /// Called with the memory used by the result buffers of the connection when a result set is closed,
+    /// and when a buffer would have exceeded its `MySQLMemoryBudget`.
+    func didUseMemory(_ usage: MySQLMemoryUsage)
+
+    /// Called when a connection has been taken from a pool with `ConnectionPool.getConnection(instrumentation:poolTask:)`.
+    ///
+    /// - Parameter waited: The time spent waiting for the connection.
+    /// - Parameter succeeded: Whether a connection was returned.
+    func didCheckOutConnection(waited: TimeInterval, succeeded: Bool)
+
+    /// Called instead of printing a warning or an error that is not otherwise reported.
+    func didWarn(_ message: String)
+}
+
+extension MySQLInstrumentation {
+    public func didExecute(_ metrics: MySQLStatementMetrics) {}
+
+    public func didFetch(_ metrics: MySQLFetchMetrics) {}
+
+    public func didUseMemory(_ usage: MySQLMemoryUsage) {}
+
+    public func didCheckOutConnection(waited: TimeInterval, succeeded: Bool) {}
+
+    public func didWarn(_ message: String) {
+        print(message)
+    }
+}
+
+/// The timings of the execution of a prepared statement. The difference between the sum of these times and the
+/// latency seen by the application is the time spent in completion handlers and in the application itself.
+public struct MySQLStatementMetrics {
+
+    /// The SQL text of the statement.
+    public let sql: String
+
+    /// The time the operation waited for the queue of the connection, behind the operations submitted before it.
+    public let queueWait: TimeInterval
+
+    /// The time taken to prepare the statement, 0 if it was taken from the statement cache or had been prepared by an earlier execution.
+    public let prepare: TimeInterval
+
+    /// The time taken to bind the parameters.
+    public let bind: TimeInterval
+
+    /// The time taken to execute the statement on the server, including the transfer of the whole result set when it is buffered.
+    public let execute: TimeInterval
+
+    /// Whether the execution succeeded.
+    public let succeeded: Bool
+}
+
+/// The timings and counters of the fetching of the rows of a result set.
+public struct MySQLFetchMetrics {
+
+    /// The SQL text of the statement.
+    public let sql: String
+
+    /// The time from the start of the execution to the first row being fetched, nil if there were no rows.
+    public let timeToFirstRow: TimeInterval?
+
+    /// The time spent fetching and decoding rows, excluding the time the rows were waiting to be consumed.
+    public let fetch: TimeInterval
+
+    /// The number of rows fetched.
+    public let rowCount: Int
+
+    /// The total length of the values fetched, an approximation of the bytes transferred.
+    public let bytesReceived: Int
+}
+
+/// The uptime in nanoseconds, used to measure durations for the instrumentation.
+@inline(__always) func uptime() -> UInt64 {
+    return DispatchTime.now().uptimeNanoseconds
+}
+
+/// The seconds elapsed between two uptimes.
+@inline(__always) func seconds(from start: UInt64, to end: UInt64) -> TimeInterval {
+    return end > start ? TimeInterval(end - start) / 1_000_000_000 : 0
+}
+
+/// Measures the phases of the execution of a prepared statement, doing nothing unless the statement has an instrumentation.
+struct MySQLStatementTimer {
+    private let instrumentation: MySQLInstrumentation?
+    private let enqueuedAt: UInt64
+    private var startedAt: UInt64 = 0
+    private var boundAt: UInt64 = 0
+
+    /// Start measuring the execution of `statement` as it is submitted to the queue of the connection.
+    init(_ statement: MySQLPreparedStatement) {
+        instrumentation = statement.instrumentation
+        enqueuedAt = instrumentation == nil ? 0 : uptime()
+    }
+
+    /// Record that the execution started running on the queue of the connection.
+    mutating func started() {
+        if instrumentation != nil {
+            startedAt = uptime()
+            boundAt = startedAt
+        }
+    }
+
+    /// Record that the parameters have been bound.
+    mutating func bound() {
+        if instrumentation != nil {
+            boundAt = uptime()
+        }
+    }
+
+    /// Report the execution of `statement` to the instrumentation.
+    func executed(_ statement: MySQLPreparedStatement, succeeded: Bool) {
+        guard let instrumentation = instrumentation else {
+            return
+        }
+        let metrics = MySQLStatementMetrics(sql: statement.sql, queueWait: seconds(from: enqueuedAt, to: startedAt), prepare: statement.prepareDuration,
+                                            bind: seconds(from: startedAt, to: boundAt), execute: seconds(from: boundAt, to: uptime()), succeeded: succeeded)
+        statement.prepareDuration = 0
+        instrumentation.didExecute(metrics)
+    }
+}
+
+extension ConnectionPool {
+
+    /// Get a connection from the pool, reporting the time spent waiting for it to `instrumentation`.
+    ///
+    /// - Parameter instrumentation: The instrumentation to report the wait to.
+    /// - Parameter poolTask: The function to be called with the connection.
+    public func getConnection(instrumentation: MySQLInstrumentation, poolTask: @escaping (Connection?, QueryError?) -> ()) {
+        let start = uptime()
+        getConnection { connection, error in
+            instrumentation.didCheckOutConnection(waited: seconds(from: start, to: uptime()), succeeded: connection != nil)
+            poolTask(connection, error)
+        }
+    }
+}
@@ -0,0 +1,267 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+
+import SwiftKuery
+
+/// What happens when the buffers of a result would exceed a `MySQLMemoryBudget`.
+public enum MySQLMemoryLimitPolicy {
+    /// Results are not buffered on the client while the limit is reached, and a result whose rows exceed the limit
+    /// while they are buffered is streamed from there on: the rows that did not fit are decoded as they are fetched.
+    /// The buffers needed to fetch a long value are always allocated. This is the default.
+    case fallBackToStreaming
+
+    /// Fetching a result fails with a `QueryError.databaseError` when its buffers would exceed the limit.
+    case fail
+}
+
+/// A cap on the memory used by the result buffers of the connections sharing it, typically the connections of a pool.
+///
+/// The memory counted is that of the output binds of the results, the buffers grown to fetch long values,
+/// the rows of results buffered on the client, see `MySQLResultBuffering`, estimated from the lengths of their values,
+/// and the parameter buffers of the prepared statements. The parameter buffers are counted but never refused.
+/// Set a budget as the `memoryBudget` of a connection, or pass it to `MySQLConnection.createPool`.
+public final class MySQLMemoryBudget {
+
+    /// The number of bytes the connections sharing the budget may use together.
+    public let limit: Int
+
+    /// The number of bytes each connection may use, nil if only the total is limited.
+    public let perConnectionLimit: Int?
+
+    /// What happens when the limit would be exceeded.
+    public let policy: MySQLMemoryLimitPolicy
+
+    private var bytes = 0
+    private var peakBytes = 0
+    private let lock = NSLock()
+
+    /// Initialize an instance of MySQLMemoryBudget.
+    ///
+    /// - Parameter limit: The number of bytes the connections sharing the budget may use together.
+    /// - Parameter perConnectionLimit: The number of bytes each connection may use, defaults to nil, only the total is limited.
+    /// - Parameter policy: What happens when the limit would be exceeded, defaults to `.fallBackToStreaming`.
+    public init(limit: Int, perConnectionLimit: Int? = nil, policy: MySQLMemoryLimitPolicy = .fallBackToStreaming) {
+        self.limit = max(limit, 0)
+        self.perConnectionLimit = perConnectionLimit.map { max($0, 0) }
+        self.policy = policy
+    }
+
+    /// The number of bytes in use by the connections sharing the budget.
+    public var current: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return bytes
+    }
+
+    /// The highest number of bytes in use at the same time since the budget was created or `resetPeak()` was called.
+    public var peak: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return peakBytes
+    }
+
+    /// Restart the measure of `peak` from the current usage.
+    public func resetPeak() {
+        lock.lock()
+        defer { lock.unlock() }
+        peakBytes = bytes
+    }
+
+    /// Add bytes to the usage, unless `refusable` and they would exceed the limit.
+    ///
+    /// - Returns: Whether the bytes were added.
+    func add(_ count: Int, refusable: Bool) -> Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        guard !refusable || bytes + count <= limit else {
+            return false
+        }
+        bytes += count
+        peakBytes = max(peakBytes, bytes)
+        return true
+    }
+
+    func remove(_ count: Int) {
+        lock.lock()
+        defer { lock.unlock() }
+        bytes = max(bytes - count, 0)
+    }
+
+    /// The usage and peak of the budget.
+    func snapshot() -> (bytes: Int, peak: Int) {
+        lock.lock()
+        defer { lock.unlock() }
+        return (bytes, peakBytes)
+    }
+}
+
+/// The memory used by the result buffers of a connection and of the connections sharing its budget,
+/// reported by `MySQLInstrumentation.didUseMemory(_:)`.
+public struct MySQLMemoryUsage {
+
+    /// The number of bytes in use by the connection.
+    public let connectionBytes: Int
+
+    /// The highest number of bytes in use by the connection at the same time.
+    public let connectionPeak: Int
+
+    /// The number of bytes in use by the connections sharing the budget, or by the connection if it has no budget.
+    public let poolBytes: Int
+
+    /// The highest number of bytes in use by the connections sharing the budget at the same time.
+    public let poolPeak: Int
+
+    /// The limit of the budget of the connection, nil if it has none.
+    public let limit: Int?
+
+    /// Whether the usage was reported because a buffer would have exceeded the limit.
+    public let limitExceeded: Bool
+}
+
+/// The memory accounted to one connection, and to its budget if it has one.
+/// The buffers of the connection are allocated on its queue, but they can be freed from any thread.
+final class MySQLMemoryAccount {
+
+    private var bytes = 0
+    private var peakBytes = 0
+    private var currentBudget: MySQLMemoryBudget? = nil
+    private let lock = NSLock()
+
+    /// The budget the memory is also counted against. The bytes in use are moved to a new budget when it is changed.
+    var budget: MySQLMemoryBudget? {
+        get {
+            lock.lock()
+            defer { lock.unlock() }
+            return currentBudget
+        }
+        set {
+            lock.lock()
+            defer { lock.unlock() }
+            guard newValue !== currentBudget else {
+                return
+            }
+            currentBudget?.remove(bytes)
+            _ = newValue?.add(bytes, refusable: false)
+            currentBudget = newValue
+        }
+    }
+
+    /// The policy of the budget, nil if there is none.
+    var policy: MySQLMemoryLimitPolicy? {
+        return budget?.policy
+    }
+
+    /// The number of bytes in use by the connection.
+    var current: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return bytes
+    }
+
+    /// The highest number of bytes in use by the connection at the same time.
+    var peak: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return peakBytes
+    }
+
+    /// Count memory that is allocated regardless of the limit.
+    func allocated(_ count: Int) {
+        _ = add(count, refusable: false)
+    }
+
+    /// Count memory needed to continue fetching a result, refused only if it would exceed the limit under the `.fail` policy.
+    ///
+    /// - Returns: Whether the memory may be allocated.
+    func reserve(_ count: Int) -> Bool {
+        return add(count, refusable: policy == .fail)
+    }
+
+    /// Count memory used to buffer rows, refused if it would exceed the limit, whatever the policy.
+    ///
+    /// - Returns: Whether the memory may be allocated.
+    func reserveBuffer(_ count: Int) -> Bool {
+        return add(count, refusable: true)
+    }
+
+    /// Count memory that has been freed.
+    func released(_ count: Int) {
+        guard count > 0 else {
+            return
+        }
+        lock.lock()
+        defer { lock.unlock() }
+        bytes = max(bytes - count, 0)
+        currentBudget?.remove(count)
+    }
+
+    /// Whether a new result may be buffered on the client, which is not the case when the limit is reached
+    /// and the policy is to fall back to streaming.
+    var allowsBuffering: Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        guard let budget = currentBudget, budget.policy == .fallBackToStreaming else {
+            return true
+        }
+        if let perConnectionLimit = budget.perConnectionLimit, bytes >= perConnectionLimit {
+            return false
+        }
+        return budget.current < budget.limit
+    }
+
+    /// The usage of the connection and of its budget.
+    ///
+    /// - Parameter limitExceeded: Whether the usage is reported because a buffer would have exceeded the limit.
+    func usage(limitExceeded: Bool = false) -> MySQLMemoryUsage {
+        lock.lock()
+        defer { lock.unlock() }
+        let pool = currentBudget?.snapshot() ?? (bytes, peakBytes)
+        return MySQLMemoryUsage(connectionBytes: bytes, connectionPeak: peakBytes, poolBytes: pool.bytes, poolPeak: pool.peak, limit: currentBudget?.limit, limitExceeded: limitExceeded)
+    }
+
+    /// The error returned when a buffer of `count` bytes is refused.
+    func limitError(reserving count: Int) -> QueryError {
+        let budget = self.budget
+        if let perConnectionLimit = budget?.perConnectionLimit, current + count > perConnectionLimit {
+            return QueryError.databaseError("Result buffer of \(count) bytes refused: memory limit of \(perConnectionLimit) bytes per connection exceeded")
+        }
+        return QueryError.databaseError("Result buffer of \(count) bytes refused: memory limit of \(budget?.limit ?? 0) bytes exceeded")
+    }
+
+    private func add(_ count: Int, refusable: Bool) -> Bool {
+        guard count > 0 else {
+            return true
+        }
+        lock.lock()
+        defer { lock.unlock() }
+        guard let budget = currentBudget else {
+            bytes += count
+            peakBytes = max(peakBytes, bytes)
+            return true
+        }
+        if refusable, let perConnectionLimit = budget.perConnectionLimit, bytes + count > perConnectionLimit {
+            return false
+        }
+        guard budget.add(count, refusable: refusable) else {
+            return false
+        }
+        bytes += count
+        peakBytes = max(peakBytes, bytes)
+        return true
+    }
+}
@@ -0,0 +1,571 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+import Dispatch
+
+import SwiftKuery
+
+/// How the rows of the partitions of a `MySQLPartitionedScan` are merged into one stream.
+public enum MySQLPartitionOrder {
+    /// The batches are returned as they are fetched, from whichever partition is ready first, the default.
+    case unordered
+
+    /// The rows of each partition are returned after those of the partitions with lower keys, so that the rows of
+    /// a `Select` ordered by the key column are returned in order. The partitions are still executed concurrently,
+    /// each fetching a bounded number of batches ahead of the partition being returned.
+    case keyOrder
+}
+
+/// The rows of a `Select` read concurrently from key ranges on separate connections of a pool,
+/// created by `ConnectionPool.scan(_:parameters:key:partitions:batchSize:order:onCompletion:)`.
+///
+/// Each partition fetches up to two batches ahead of the consumer, and stops while they are not consumed.
+/// The first error of a partition ends the scan. The rows must be read by one consumer at a time, and
+/// `done()` must be called if the scan is abandoned before the last row, to return the connections to the pool.
+public final class MySQLPartitionedScan: ResultFetcher {
+
+    /// The number of partitions the rows are read from, which is smaller than requested when the range of keys is.
+    public var partitionCount: Int {
+        return partitions.count
+    }
+
+    private let partitions: [MySQLScanPartition]
+    private let order: MySQLPartitionOrder
+    private let batchSize: Int
+
+    /// The number of batches each partition fetches ahead of the consumer.
+    private static let prefetchBatches = 2
+
+    /// The number of rows read before continuing on another thread, so that result sets answering synchronously,
+    /// such as cached results, do not grow the stack.
+    private static let rowsPerHop = 64
+
+    private let lock = NSLock()
+    private var titles = [String]()
+    private var current = 0
+    private var error: Error? = nil
+    private var closed = false
+    private var waiter: ((([[Any?]]?, Error?)) -> ())? = nil
+    private var rows = [[Any?]]()
+    private var rowIndex = 0
+
+    init(partitions: [MySQLScanPartition], order: MySQLPartitionOrder, batchSize: Int) {
+        self.partitions = partitions
+        self.order = order
+        self.batchSize = max(batchSize, 1)
+    }
+
+    deinit {
+        done()
+    }
+
+    /// Fetch the next row of the scan. This function is non-blocking.
+    ///
+    /// - Parameter callback: A callback to call when the next row is ready, with nil when there are no more rows.
+    public func fetchNext(callback: @escaping (([Any?]?, Error?)) -> ()) {
+        lock.lock()
+        if rowIndex < rows.count {
+            let row = rows[rowIndex]
+            rowIndex += 1
+            lock.unlock()
+            return callback((row, nil))
+        }
+        lock.unlock()
+
+        fetchNextBatch { batch, error in
+            guard let batch = batch else {
+                return callback((nil, error))
+            }
+            self.lock.lock()
+            self.rows = batch
+            self.rowIndex = 1
+            self.lock.unlock()
+            callback((batch[0], nil))
+        }
+    }
+
+    /// Fetch the next batch of rows of the scan, of up to `batchSize` rows of a single partition. This function is non-blocking.
+    ///
+    /// - Parameter callback: A callback to call when the next rows are ready, with nil when there are no more rows.
+    public func fetchNextBatch(callback: @escaping (([[Any?]]?, Error?)) -> ()) {
+        lock.lock()
+        if let batch = takeBatch() {
+            let reads = scheduleReads()
+            lock.unlock()
+            start(reads)
+            return callback((batch, nil))
+        }
+        if isFinished {
+            let error = self.error
+            lock.unlock()
+            return callback((nil, error))
+        }
+        waiter = callback
+        lock.unlock()
+    }
+
+    /// Fetch the column titles of the scan. This function is non-blocking.
+    ///
+    /// - Parameter callback: A closure that accepts a tuple containing an optional array of column titles of type String and an optional Error
+    public func fetchTitles(callback: @escaping (([String]?, Error?)) -> ()) {
+        lock.lock()
+        let titles = self.titles
+        lock.unlock()
+        callback((titles, nil))
+    }
+
+    /// Stop the scan, discarding the rows that have not been read, and return the connections to the pool.
+    public func done() {
+        lock.lock()
+        closed = true
+        let waiter = self.waiter
+        self.waiter = nil
+        let error = self.error
+        var detached = [(ResultSet?, Connection?)]()
+        for partition in partitions {
+            partition.batches = []
+            // A partition reading a batch is closed when the batch is received
+            if !partition.reading {
+                detached.append(partition.detach())
+            }
+        }
+        lock.unlock()
+
+        MySQLScanPartition.close(detached)
+        waiter?((nil, error))
+    }
+
+    /// Execute the queries of the partitions, each on its own connection of the pool, and start fetching their rows.
+    func open(pool: ConnectionPool, parameters: [Any?], onCompletion: @escaping (Error?) -> ()) {
+        let group = DispatchGroup()
+        for (index, partition) in partitions.enumerated() {
+            group.enter()
+            pool.getConnection { connection, error in
+                guard let connection = connection else {
+                    self.failed(error ?? QueryError.connection("No connection available for partition \(index)"))
+                    return group.leave()
+                }
+                partition.execute(on: connection, parameters: parameters) { resultSet, error in
+                    if let error = error {
+                        self.failed(error)
+                        return group.leave()
+                    }
+                    guard index == 0, let resultSet = resultSet else {
+                        return group.leave()
+                    }
+                    resultSet.getColumnTitles { titles, error in
+                        self.lock.lock()
+                        self.titles = titles ?? []
+                        self.lock.unlock()
+                        if let error = error {
+                            self.failed(error)
+                        }
+                        group.leave()
+                    }
+                }
+            }
+        }
+
+        group.notify(queue: DispatchQueue.global()) {
+            self.lock.lock()
+            let error = self.error
+            let reads = self.scheduleReads()
+            self.lock.unlock()
+            if let error = error {
+                self.done()
+                return onCompletion(error)
+            }
+            self.start(reads)
+            onCompletion(nil)
+        }
+    }
+
+    private func failed(_ error: Error) {
+        lock.lock()
+        if self.error == nil {
+            self.error = error
+        }
+        lock.unlock()
+    }
+
+    /// Whether all the rows have been returned, or the scan failed. Called with the lock held.
+    private var isFinished: Bool {
+        if error != nil || closed {
+            return true
+        }
+        for partition in partitions where !partition.finished || !partition.batches.isEmpty {
+            return false
+        }
+        return true
+    }
+
+    /// Take the next batch to return, if one has been fetched. Called with the lock held.
+    private func takeBatch() -> [[Any?]]? {
+        guard error == nil && !closed else {
+            return nil
+        }
+        switch order {
+        case .keyOrder:
+            while current < partitions.count && partitions[current].finished && partitions[current].batches.isEmpty {
+                current += 1
+            }
+            guard current < partitions.count, !partitions[current].batches.isEmpty else {
+                return nil
+            }
+            return partitions[current].batches.removeFirst()
+        case .unordered:
+            // Start from the partition after the last one returned, so that no partition is starved
+            for offset in 0 ..< partitions.count {
+                let index = (current + offset) % partitions.count
+                if !partitions[index].batches.isEmpty {
+                    current = (index + 1) % partitions.count
+                    return partitions[index].batches.removeFirst()
+                }
+            }
+            return nil
+        }
+    }
+
+    /// Mark the partitions with room for more batches as reading, and return them with their result sets. Called with the lock held.
+    private func scheduleReads() -> [(MySQLScanPartition, ResultSet)] {
+        guard error == nil && !closed else {
+            return []
+        }
+        var reads = [(MySQLScanPartition, ResultSet)]()
+        for partition in partitions where !partition.reading && !partition.finished && partition.batches.count < MySQLPartitionedScan.prefetchBatches {
+            if let resultSet = partition.resultSet {
+                partition.reading = true
+                reads.append((partition, resultSet))
+            }
+        }
+        return reads
+    }
+
+    private func start(_ reads: [(MySQLScanPartition, ResultSet)]) {
+        for (partition, resultSet) in reads {
+            var rows = [[Any?]]()
+            rows.reserveCapacity(batchSize)
+            read(partition, resultSet, rows: rows, depth: 0)
+        }
+    }
+
+    private func read(_ partition: MySQLScanPartition, _ resultSet: ResultSet, rows: [[Any?]], depth: Int) {
+        resultSet.nextRow { row, error in
+            guard let row = row, error == nil else {
+                return self.received(rows, of: partition, ended: true, error: error)
+            }
+            var rows = rows
+            rows.append(row)
+            guard rows.count < self.batchSize else {
+                return self.received(rows, of: partition, ended: false, error: nil)
+            }
+            guard depth < MySQLPartitionedScan.rowsPerHop else {
+                return DispatchQueue.global().async {
+                    self.read(partition, resultSet, rows: rows, depth: 0)
+                }
+            }
+            self.read(partition, resultSet, rows: rows, depth: depth + 1)
+        }
+    }
+
+    private func received(_ batch: [[Any?]], of partition: MySQLScanPartition, ended: Bool, error: Error?) {
+        lock.lock()
+        partition.reading = false
+        if closed {
+            let detached = partition.detach()
+            lock.unlock()
+            return MySQLScanPartition.close([detached])
+        }
+        if !batch.isEmpty && error == nil {
+            partition.batches.append(batch)
+        }
+        var detached = [(ResultSet?, Connection?)]()
+        if ended {
+            partition.finished = true
+            detached.append(partition.detach())
+        }
+        if let error = error, self.error == nil {
+            self.error = error
+        }
+
+        var delivery: ((([[Any?]]?, Error?)) -> (), [[Any?]]?)? = nil
+        if let waiter = waiter {
+            if let next = takeBatch() {
+                self.waiter = nil
+                delivery = (waiter, next)
+            } else if isFinished {
+                self.waiter = nil
+                delivery = (waiter, nil)
+            }
+        }
+        let reads = scheduleReads()
+        let failed = self.error != nil
+        let scanError = self.error
+        lock.unlock()
+
+        MySQLScanPartition.close(detached)
+        start(reads)
+        if let (waiter, next) = delivery {
+            waiter((next, next == nil ? scanError : nil))
+        }
+        if failed {
+            // Return the connections of the other partitions
+            done()
+        }
+    }
+
+    /// The minimum and maximum values of the key column in its table, nil if the table is empty.
+    static func keyBounds(of key: Column, connection: Connection, onCompletion: @escaping ((lower: Int64, upper: Int64)?, Error?) -> ()) {
+        guard let table = key.table else {
+            return onCompletion(nil, QueryError.syntaxError("The key column \(key.name) does not belong to a table"))
+        }
+        let quote = connection.queryBuilder.substitutions[QueryBuilder.QuerySubstitutionNames.identifierQuoteCharacter.rawValue]
+        let column = quote + key.name + quote
+        let raw = "SELECT MIN(" + column + "), MAX(" + column + ") FROM " + quote + table.tableName + quote
+        connection.execute(raw) { result in
+            guard let resultSet = result.asResultSet else {
+                return onCompletion(nil, result.asError ?? QueryError.databaseError("The bounds of the key column \(key.name) were not returned"))
+            }
+            resultSet.nextRow { row, error in
+                resultSet.done()
+                guard let row = row, row.count == 2 else {
+                    return onCompletion(nil, error ?? QueryError.databaseError("The bounds of the key column \(key.name) were not returned"))
+                }
+                guard let lower = integer(row[0]), let upper = integer(row[1]) else {
+                    if row[0] == nil {
+                        // The table is empty, or the key is NULL in every row
+                        return onCompletion(nil, nil)
+                    }
+                    return onCompletion(nil, QueryError.unsupported("The key column \(key.name) is not an integer column"))
+                }
+                onCompletion((lower, upper), nil)
+            }
+        }
+    }
+
+    /// Split the keys between `bounds` into up to `count` contiguous ranges of about the same width.
+    /// The first range has no lower bound and the last no upper bound, so that rows inserted outside
+    /// the bounds while the partitions are opened belong to one of them.
+    static func ranges(between bounds: (lower: Int64, upper: Int64)?, count: Int) -> [(from: Int64?, to: Int64?)] {
+        guard let bounds = bounds, count > 1, bounds.upper > bounds.lower else {
+            return [(nil, nil)]
+        }
+        let span = UInt64(bitPattern: bounds.upper &- bounds.lower)
+        let partitions = min(UInt64(count), span)
+        var ranges = [(from: Int64?, to: Int64?)]()
+        var from: Int64? = nil
+        for index in 1 ..< partitions {
+            // span * index / partitions, without overflowing
+            let offset = span / partitions * index + span % partitions * index / partitions
+            let start = bounds.lower &+ Int64(bitPattern: offset)
+            ranges.append((from, start))
+            from = start
+        }
+        ranges.append((from, nil))
+        return ranges
+    }
+
+    /// The query of each range of keys. The range is the where clause of a `Select` that has none and whose clauses
+    /// apply to each row separately. Otherwise it filters the rows of the `Select` used as a derived table, so that
+    /// grouping, DISTINCT, aggregates and LIMIT apply to all the rows instead of to those of each partition, and MySQL
+    /// merges the derived table into the outer query when they do not. The key column must then be one of the selected fields.
+    static func partitions(of select: Select, key: Column, ranges: [(from: Int64?, to: Int64?)], queryBuilder: QueryBuilder) throws -> [MySQLScanPartition] {
+        guard (select.whereClause != nil || combinesRows(select)) && ranges.count > 1 else {
+            return ranges.map { range in
+                guard let filter = filter(key, range) else {
+                    return MySQLScanPartition(query: select)
+                }
+                return MySQLScanPartition(query: select.where(filter))
+            }
+        }
+
+        let sql: String
+        do {
+            sql = try select.build(queryBuilder: queryBuilder)
+        } catch let error {
+            throw QueryError.syntaxError("Unable to build query: \(error.localizedDescription)")
+        }
+        let quote = queryBuilder.substitutions[QueryBuilder.QuerySubstitutionNames.identifierQuoteCharacter.rawValue]
+        let column = quote + "partitioned_scan" + quote + "." + quote + (key.alias ?? key.name) + quote
+        return ranges.map { range in
+            var conditions = [String]()
+            if let from = range.from {
+                conditions.append(column + " >= \(from)")
+            }
+            if let to = range.to {
+                conditions.append(column + " < \(to)")
+            }
+            return MySQLScanPartition(raw: "SELECT * FROM (" + sql + ") AS " + quote + "partitioned_scan" + quote + " WHERE " + conditions.joined(separator: " AND "))
+        }
+    }
+
+    /// Whether the result of a `Select` depends on several rows of its tables, which one partition only has some of.
+    private static func combinesRows(_ select: Select) -> Bool {
+        if select.distinct || select.havingClause != nil || select.rowsToReturn != nil || select.offset != nil || select.top != nil {
+            return true
+        }
+        if let groupBy = select.groupBy, !groupBy.isEmpty {
+            return true
+        }
+        return select.fields?.contains { $0 is AggregateColumnExpression } ?? false
+    }
+
+    private static func filter(_ key: Column, _ range: (from: Int64?, to: Int64?)) -> Filter? {
+        switch (range.from, range.to) {
+        case let (from?, to?):
+            return key >= Int(from) && key < Int(to)
+        case let (from?, nil):
+            return key >= Int(from)
+        case let (nil, to?):
+            return key < Int(to)
+        case (nil, nil):
+            return nil
+        }
+    }
+
+    private static func integer(_ value: Any?) -> Int64? {
+        switch value {
+        case let value as Int64:
+            return value
+        case let value as Int32:
+            return Int64(value)
+        case let value as Int16:
+            return Int64(value)
+        case let value as Int8:
+            return Int64(value)
+        case let value as Int:
+            return Int64(value)
+        case let value as UInt64:
+            return value <= UInt64(Int64.max) ? Int64(value) : nil
+        case let value as String:
+            // Values of the text protocol
+            return Int64(value)
+        default:
+            return nil
+        }
+    }
+}
+
+/// The query of one range of keys of a `MySQLPartitionedScan`, and its fetched batches. Its state is protected by the lock of the scan.
+final class MySQLScanPartition {
+    private let query: Query?
+    private let raw: String?
+
+    var connection: Connection? = nil
+    var resultSet: ResultSet? = nil
+    var batches = [[[Any?]]]()
+    var reading = false
+    var finished = false
+
+    init(query: Query) {
+        self.query = query
+        self.raw = nil
+    }
+
+    init(raw: String) {
+        self.query = nil
+        self.raw = raw
+    }
+
+    /// Execute the query of the partition on a connection, which is kept until the partition is closed.
+    func execute(on connection: Connection, parameters: [Any?], onCompletion: @escaping (ResultSet?, Error?) -> ()) {
+        self.connection = connection
+        let handler: (QueryResult) -> () = { result in
+            guard let resultSet = result.asResultSet else {
+                return onCompletion(nil, result.asError ?? QueryError.databaseError("The query of the partition did not return rows"))
+            }
+            self.resultSet = resultSet
+            onCompletion(resultSet, nil)
+        }
+        switch (query, raw, parameters.isEmpty) {
+        case let (query?, _, true):
+            connection.execute(query: query, onCompletion: handler)
+        case let (query?, _, false):
+            connection.execute(query: query, parameters: parameters, onCompletion: handler)
+        case let (nil, raw?, true):
+            connection.execute(raw, onCompletion: handler)
+        case let (nil, raw?, false):
+            connection.execute(raw, parameters: parameters, onCompletion: handler)
+        default:
+            onCompletion(nil, QueryError.syntaxError("The partition has no query"))
+        }
+    }
+
+    /// Take the result set and the connection of the partition, to be closed once the lock of the scan is released.
+    func detach() -> (ResultSet?, Connection?) {
+        let detached = (resultSet, connection)
+        resultSet = nil
+        connection = nil
+        return detached
+    }
+
+    /// Release the result sets and return the connections of partitions to the pool.
+    static func close(_ detached: [(ResultSet?, Connection?)]) {
+        for (resultSet, connection) in detached {
+            resultSet?.done()
+            connection?.closeConnection()
+        }
+    }
+}
+
+extension ConnectionPool {
+
+    /// Read the rows of a `Select` concurrently, from ranges of the values of an integer key column, each read on
+    /// its own connection of the pool, and merge them into one stream of rows, see `MySQLPartitionedScan`.
+    ///
+    /// The bounds of the key are looked up in the table of the key column, and split into up to `partitions` ranges
+    /// of about the same width, so the partitions are balanced when the keys are evenly distributed, as auto increment
+    /// keys usually are. Rows with a NULL key are not returned. The pool must be able to provide `partitions` connections
+    /// at the same time. The partitions are not read in a transaction, so they do not see a single snapshot of the table.
+    ///
+    /// A `Select` with a where clause, or that is grouped, distinct, limited or has aggregate fields, is read as a derived
+    /// table filtered by each range, so that its clauses apply to all its rows rather than to each partition separately.
+    /// The key column must then be one of its selected fields. When the clauses combine rows, each partition computes
+    /// the whole result of the `Select` on the server and only returns the rows of its range.
+    ///
+    /// - Parameter select: The query to read the rows of.
+    /// - Parameter parameters: The parameters of the query.
+    /// - Parameter key: The integer column splitting the rows into partitions, usually the primary key.
+    /// - Parameter partitions: The number of partitions to read concurrently.
+    /// - Parameter batchSize: The maximum number of rows of the batches read from each partition.
+    /// - Parameter order: How the rows of the partitions are merged, defaults to `.unordered`.
+    /// - Parameter onCompletion: The function to be called with the scan when the queries of all the partitions have been executed, or with the error.
+    public func scan(_ select: Select, parameters: [Any?] = [], key: Column, partitions: Int, batchSize: Int = 256, order: MySQLPartitionOrder = .unordered, onCompletion: @escaping (MySQLPartitionedScan?, Error?) -> ()) {
+        getConnection { connection, error in
+            guard let connection = connection else {
+                return onCompletion(nil, error ?? QueryError.connection("No connection available"))
+            }
+            MySQLPartitionedScan.keyBounds(of: key, connection: connection) { bounds, error in
+                let queryBuilder = connection.queryBuilder
+                connection.closeConnection()
+                if let error = error {
+                    return onCompletion(nil, error)
+                }
+                let scan: MySQLPartitionedScan
+                do {
+                    let ranges = MySQLPartitionedScan.ranges(between: bounds, count: partitions)
+                    scan = MySQLPartitionedScan(partitions: try MySQLPartitionedScan.partitions(of: select, key: key, ranges: ranges, queryBuilder: queryBuilder), order: order, batchSize: batchSize)
+                } catch let error {
+                    return onCompletion(nil, error)
+                }
+                scan.open(pool: self, parameters: parameters) { error in
+                    onCompletion(error == nil ? scan : nil, error)
+                }
+            }
+        }
+    }
+}
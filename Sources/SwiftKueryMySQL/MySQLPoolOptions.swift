@@ -0,0 +1,290 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+import Dispatch
+
+import SwiftKuery
+
+/// MySQL specific options of the connection pools created by `MySQLConnection.createPool`, controlling how
+/// connections are opened ahead of demand, checked while idle and replaced once they are too old.
+public struct MySQLPoolOptions {
+
+    /// The maximum number of connections opened at the same time when the pool is created and when spare
+    /// connections are replenished, defaults to 4.
+    public var maxConcurrentConnects: Int
+
+    /// The number of connected spare connections kept ready for the pool to hand out when demand spikes,
+    /// replenished in the background as they are used, defaults to 0.
+    public var spareConnections: Int
+
+    /// The interval at which connections idle for at least that long are validated in the background with a ping,
+    /// so that dead connections are replaced before they are handed out. Defaults to nil, no background validation.
+    public var validationInterval: TimeInterval?
+
+    /// The time after which a connection is replaced when it is next taken from the pool, defaults to nil, no limit.
+    public var maxLifetime: TimeInterval?
+
+    /// The idle time after which a connection is replaced when it is next taken from the pool, defaults to nil, no limit.
+    public var idleTimeout: TimeInterval?
+
+    /// The number of times a connect that failed with a transient error, such as a refused connection or a server
+    /// with too many connections, is retried, defaults to 2. Errors of the credentials or the database are not retried.
+    public var connectRetries: Int
+
+    /// The delay before the first retry of a failed connect, in seconds, defaults to 0.05. The delay doubles with
+    /// each consecutive failure of the pool, up to `maxConnectRetryDelay`, and while it runs no connect of the pool
+    /// is attempted, so that concurrent connects to a server that is down do not all retry at once.
+    public var connectRetryDelay: TimeInterval
+
+    /// The longest delay between the retries of a failed connect, in seconds, defaults to 2.
+    public var maxConnectRetryDelay: TimeInterval
+
+    /// Initialize an instance of MySQLPoolOptions.
+    ///
+    /// - Parameter maxConcurrentConnects: The maximum number of connections opened at the same time.
+    /// - Parameter spareConnections: The number of connected spare connections kept ready.
+    /// - Parameter validationInterval: The interval at which idle connections are validated in the background.
+    /// - Parameter maxLifetime: The time after which a connection is replaced.
+    /// - Parameter idleTimeout: The idle time after which a connection is replaced.
+    /// - Parameter connectRetries: The number of times a connect that failed with a transient error is retried.
+    /// - Parameter connectRetryDelay: The delay before the first retry of a failed connect.
+    /// - Parameter maxConnectRetryDelay: The longest delay between the retries of a failed connect.
+    public init(maxConcurrentConnects: Int = 4, spareConnections: Int = 0, validationInterval: TimeInterval? = nil, maxLifetime: TimeInterval? = nil, idleTimeout: TimeInterval? = nil, connectRetries: Int = 2, connectRetryDelay: TimeInterval = 0.05, maxConnectRetryDelay: TimeInterval = 2) {
+        self.maxConcurrentConnects = maxConcurrentConnects
+        self.spareConnections = spareConnections
+        self.validationInterval = validationInterval
+        self.maxLifetime = maxLifetime
+        self.idleTimeout = idleTimeout
+        self.connectRetries = connectRetries
+        self.connectRetryDelay = connectRetryDelay
+        self.maxConnectRetryDelay = maxConnectRetryDelay
+    }
+}
+
+/// Opens the connections of a pool ahead of demand and validates them in the background.
+///
+/// `ConnectionPool` calls its generator synchronously, one connection at a time. The maintainer connects the
+/// initial connections of the pool, and spare connections, concurrently ahead of the calls to the generator,
+/// which then hands out a connection that is already established. Connects that fail with a transient error
+/// are retried after a delay shared by all the connects of the pool.
+final class MySQLPoolMaintainer {
+
+    private let options: MySQLPoolOptions
+    private let connect: () -> (connection: MySQLConnection?, transientFailure: Bool)
+    private let queue = DispatchQueue(label: "SwiftKueryMySQL.pool", attributes: .concurrent)
+    private let connectSlots: DispatchSemaphore
+    private let lock = NSLock()
+    private var spares = [MySQLConnection]()
+    private var pendingConnects = 0
+    private var connections = [WeakConnection]()
+    private var timer: DispatchSourceTimer?
+
+    /// The number of connects that failed since the last one that succeeded.
+    private var consecutiveFailures = 0
+
+    /// The uptime in nanoseconds before which no connect is attempted, after a failure.
+    private var retryAt: UInt64 = 0
+
+    /// Initialize an instance of MySQLPoolMaintainer.
+    ///
+    /// - Parameter options: The options of the pool.
+    /// - Parameter connect: A function creating and connecting a connection, returning nil if it failed to connect,
+    ///                      and whether the failure was transient so that the connect may be retried.
+    init(options: MySQLPoolOptions, connect: @escaping () -> (connection: MySQLConnection?, transientFailure: Bool)) {
+        self.options = options
+        self.connect = connect
+        self.connectSlots = DispatchSemaphore(value: max(options.maxConcurrentConnects, 1))
+
+        if let interval = options.validationInterval, interval > 0 {
+            let timer = DispatchSource.makeTimerSource(queue: queue)
+            timer.schedule(deadline: .now() + interval, repeating: interval)
+            timer.setEventHandler { [weak self] in
+                self?.validateIdleConnections(idleFor: interval)
+            }
+            timer.resume()
+            self.timer = timer
+        }
+    }
+
+    deinit {
+        timer?.cancel()
+    }
+
+    /// Connect `count` connections concurrently, waiting for all of them, and keep them for the next calls to `next()`.
+    /// The first connection is established before the others, so that they can resume its TLS session,
+    /// and none of the others is attempted if it fails.
+    func prefill(_ count: Int) {
+        let group = DispatchGroup()
+        for index in 0 ..< count {
+            startConnect(group: group)
+            if index == 0 {
+                group.wait()
+                lock.lock()
+                let connected = !spares.isEmpty
+                lock.unlock()
+                guard connected else {
+                    return
+                }
+            }
+        }
+        group.wait()
+    }
+
+    /// Return a connected connection for the pool, a spare one if there is one.
+    func next() -> Connection? {
+        lock.lock()
+        let spare = spares.popLast()
+        lock.unlock()
+        defer {
+            replenish()
+        }
+        if let spare = spare, spare.isConnected {
+            return spare
+        }
+        return makeConnection()
+    }
+
+    private func replenish() {
+        lock.lock()
+        let missing = options.spareConnections - spares.count - pendingConnects
+        lock.unlock()
+        for _ in 0 ..< max(missing, 0) {
+            startConnect(group: nil)
+        }
+    }
+
+    private func startConnect(group: DispatchGroup?) {
+        lock.lock()
+        pendingConnects += 1
+        lock.unlock()
+        group?.enter()
+        queue.async {
+            let connection = self.makeConnection()
+            self.lock.lock()
+            self.pendingConnects -= 1
+            if let connection = connection {
+                self.spares.append(connection)
+            }
+            self.lock.unlock()
+            group?.leave()
+        }
+    }
+
+    private func makeConnection() -> MySQLConnection? {
+        var retries = 0
+        while true {
+            waitForRetry()
+            connectSlots.wait()
+            let result = connect()
+            connectSlots.signal()
+            if let connection = result.connection {
+                return connected(connection)
+            }
+            failed()
+            guard result.transientFailure && retries < options.connectRetries else {
+                return nil
+            }
+            retries += 1
+        }
+    }
+
+    private func connected(_ connection: MySQLConnection) -> MySQLConnection {
+        lock.lock()
+        consecutiveFailures = 0
+        retryAt = 0
+        lock.unlock()
+
+        connection.poolLifetime = MySQLPoolLifetime(maxLifetime: options.maxLifetime, idleTimeout: options.idleTimeout)
+        if options.validationInterval != nil {
+            lock.lock()
+            connections = connections.filter { $0.connection != nil }
+            connections.append(WeakConnection(connection))
+            lock.unlock()
+        }
+        return connection
+    }
+
+    /// Count a failed connect and delay the next attempts of the pool, by a delay that doubles with each consecutive
+    /// failure and is spread between half and all of its value so that the retries of concurrent connects do not coincide.
+    private func failed() {
+        lock.lock()
+        defer { lock.unlock() }
+        consecutiveFailures += 1
+        let exponent = Double(min(consecutiveFailures - 1, 30))
+        let delay = min(max(options.connectRetryDelay, 0) * pow(2, exponent), max(options.maxConnectRetryDelay, 0))
+        let now = uptime()
+        let spread = 0.5 + Double(now % 1024) / 2048
+        retryAt = max(retryAt, now + nanoseconds(delay * spread))
+    }
+
+    /// Wait until the delay after the last failed connect has passed.
+    private func waitForRetry() {
+        lock.lock()
+        let retryAt = self.retryAt
+        lock.unlock()
+        let now = uptime()
+        if now < retryAt {
+            Thread.sleep(forTimeInterval: Double(retryAt - now) / 1_000_000_000)
+        }
+    }
+
+    private func validateIdleConnections(idleFor interval: TimeInterval) {
+        lock.lock()
+        let live = connections
+        lock.unlock()
+        for weakConnection in live {
+            weakConnection.connection?.validateIfIdle(for: interval)
+        }
+    }
+}
+
+/// The limits on the age of a connection of a pool.
+struct MySQLPoolLifetime {
+    let maxLifetime: TimeInterval?
+    let idleTimeout: TimeInterval?
+
+    /// Whether a connection established at `connectedAt` and last used at `lastIO`, uptimes in nanoseconds, is past the limits.
+    func isExpired(connectedAt: UInt64, lastIO: UInt64, now: UInt64) -> Bool {
+        if let maxLifetime = maxLifetime, now >= connectedAt + nanoseconds(maxLifetime) {
+            return true
+        }
+        if let idleTimeout = idleTimeout, now >= lastIO + nanoseconds(idleTimeout) {
+            return true
+        }
+        return false
+    }
+}
+
+/// Convert a time interval to nanoseconds, clamped so that it can be added to an uptime without overflowing.
+func nanoseconds(_ interval: TimeInterval) -> UInt64 {
+    let maxNanoseconds: UInt64 = 1 << 62
+    guard interval > 0 else {
+        return 0
+    }
+    guard interval * 1_000_000_000 < Double(maxNanoseconds) else {
+        return maxNanoseconds
+    }
+    return UInt64(interval * 1_000_000_000)
+}
+
+private struct WeakConnection {
+    weak var connection: MySQLConnection?
+
+    init(_ connection: MySQLConnection) {
+        self.connection = connection
+    }
+}
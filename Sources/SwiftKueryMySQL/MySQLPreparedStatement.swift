@@ -22,13 +22,54 @@ import CMySQL
 /// MySQL implementation for prepared statements.
 public class MySQLPreparedStatement: PreparedStatement {
     var statement: UnsafeMutablePointer<MYSQL_STMT>?
-    internal let query: Query?
+    internal var query: Query?
 
     private var binds = [MYSQL_BIND]()
+    private var slots = [BindSlot]()
     internal var bindsCapacity = 0
     internal var bindPtr: UnsafeMutablePointer<MYSQL_BIND>? = nil
     private var mysql: UnsafeMutablePointer<MYSQL>?
 
+    /// The output binds of the last result set, reused by the next execution returning the same columns.
+    internal var resultArena: MySQLResultBindArena?
+
+    /// The result columns of the statement, read on its first execution returning a result set.
+    private var columns: MySQLResultMetadata?
+
+    /// Whether the result sets of this statement are streamed from the server or buffered on the client.
+    /// When nil, the `resultBuffering` of the connection is used.
+    public var resultBuffering: MySQLResultBuffering? = nil
+
+    /// The number of rows to fetch from the server at a time through a server side cursor.
+    /// When set, executions of this statement open a read-only cursor (`CURSOR_TYPE_READ_ONLY`) and the server
+    /// sends the rows in blocks of `STMT_ATTR_PREFETCH_ROWS` rows, which keeps client memory bounded for large scans.
+    /// When nil, the default, rows are returned without a cursor. A cursor takes precedence over `resultBuffering`.
+    public var cursorPrefetchRows: UInt? = nil
+    private var appliedCursorPrefetchRows: UInt? = nil
+
+    /// Whether the result of the last execution was released before all its rows were read,
+    /// in which case the statement is reset before it is returned to the statement cache.
+    internal var hasUnreadResult = false
+
+    /// The statement cache this statement is returned to on release, if any.
+    internal weak var cache: MySQLStatementCache?
+    internal var cacheKey: String?
+    internal var connectionID: UInt = 0
+
+    /// The SQL text of the statement, the instrumentation of its connection and the time taken to prepare it,
+    /// which is reported with the next execution.
+    internal var sql = ""
+    internal var instrumentation: MySQLInstrumentation?
+    internal var prepareDuration: TimeInterval = 0
+
+    /// The account of the connection the parameter buffers and the result binds of the statement are counted against.
+    internal var memory: MySQLMemoryAccount?
+
+    /// The serial queue of the connection, on which the statement and the connection handle are used,
+    /// and the connection that set it on the queue.
+    internal var queue: DispatchQueue?
+    internal var queueOwner: ObjectIdentifier?
+
     init(query: Query? = nil, mysql: UnsafeMutablePointer<MYSQL>?, statement: UnsafeMutablePointer<MYSQL_STMT>?) {
         self.mysql = mysql
         self.statement = statement
@@ -37,25 +78,109 @@ public class MySQLPreparedStatement: PreparedStatement {
 
     deinit {
         if self.statement != nil {
-            print("WARNING: Deinitialising a prepared statement that has not been explictly released. Failing to release prepared statements will leak memory.")
+            warn("WARNING: Deinitialising a prepared statement that has not been explictly released. Failing to release prepared statements will leak memory.")
         }
     }
 
+    /// Report a warning to the instrumentation of the connection, or print it if there is none.
+    func warn(_ message: String) {
+        if let instrumentation = instrumentation {
+            instrumentation.didWarn(message)
+        } else {
+            print(message)
+        }
+    }
+
+    /// Release the statement, on the queue of the connection. It is returned to the statement cache, or closed.
     func release(onCompletion: @escaping ((QueryResult) -> ())) {
+        onConnectionQueue {
+            self.releaseParameters()
+            if let cache = self.cache, cache.checkIn(self) {
+                // The statement and its binds are kept for reuse by the next execution of the same SQL
+                return onCompletion(.successNoData)
+            }
+            self.close()
+            onCompletion(.successNoData)
+        }
+    }
+
+    /// Run `work` on the queue of the connection, right away when called from it, so that the statement is never
+    /// reset or closed while another operation uses the connection handle.
+    internal func onConnectionQueue(_ work: @escaping () -> ()) {
+        guard let queue = queue, DispatchQueue.getSpecific(key: MySQLConnection.queueKey) != queueOwner else {
+            return work()
+        }
+        queue.async {
+            MySQLThread.initialize()
+            work()
+        }
+    }
+
+    internal func close() {
         deallocateBinds()
+        resultArena = nil
+        columns = nil
 
         if let statement = self.statement {
             self.statement = nil
             mysql_stmt_close(statement)
         }
-        onCompletion(.successNoData)
+    }
+
+    /// Set the cursor attributes of the statement to match `cursorPrefetchRows`, if they have changed since the last execution.
+    internal func applyCursorAttributes() -> Bool {
+        guard let statement = statement, cursorPrefetchRows != appliedCursorPrefetchRows else {
+            return true
+        }
+
+        var cursorType = UInt(cursorPrefetchRows == nil ? CURSOR_TYPE_NO_CURSOR.rawValue : CURSOR_TYPE_READ_ONLY.rawValue)
+        guard mysql_stmt_attr_set(statement, STMT_ATTR_CURSOR_TYPE, &cursorType) == mysql_false() else {
+            return false
+        }
+
+        if var prefetchRows = cursorPrefetchRows {
+            guard mysql_stmt_attr_set(statement, STMT_ATTR_PREFETCH_ROWS, &prefetchRows) == mysql_false() else {
+                return false
+            }
+        }
+
+        appliedCursorPrefetchRows = cursorPrefetchRows
+        return true
+    }
+
+    /// The result columns of the statement, read from the server metadata on first use.
+    ///
+    /// - Returns: nil if the statement does not return a result set.
+    internal func resultMetadata() -> MySQLResultMetadata? {
+        if let columns = columns {
+            return columns
+        }
+        guard let statement = statement else {
+            return nil
+        }
+        columns = MySQLResultMetadata(statement: statement)
+        return columns
+    }
+
+    /// Replace the result columns of the statement after an execution, if the server re-prepared it with different columns.
+    ///
+    /// - Returns: The result columns of the execution, or nil if it did not return a result set.
+    internal func refreshResultMetadata(_ metadata: MySQLResultMetadata) -> MySQLResultMetadata? {
+        guard let statement = statement, let mysql = mysql else {
+            return metadata
+        }
+        guard cmysql_metadata_changed(mysql) != 0 || Int(mysql_stmt_field_count(statement)) != metadata.count else {
+            return metadata
+        }
+        columns = nil
+        return resultMetadata()
     }
 
     internal func getError(_ statement: UnsafeMutablePointer<MYSQL_STMT>) -> String {
         return "ERROR \(mysql_stmt_errno(statement)): " + String(cString: mysql_stmt_error(statement))
     }
 
-    internal func allocateBinds(parameters: [Any?]) -> Bool {
+    internal func allocateBinds(parameters: [Any?], timeConverter: MySQLTimeConverter) -> Bool {
         var cols: [Column]?
         switch query {
         case let insert as Insert:
@@ -66,24 +191,26 @@ public class MySQLPreparedStatement: PreparedStatement {
             break
         }
 
+        // A multi-row insert has the parameters of each row in turn
         let columns: [Column]?
-        if cols?.count == parameters.count {
+        if let cols = cols, cols.count == parameters.count || (query is Insert && !cols.isEmpty && parameters.count % cols.count == 0) {
             columns = cols
         } else {
             columns = nil
         }
 
         if binds.isEmpty { // first parameter set, create new bind and bind it to the parameter
+            slots = [BindSlot](repeating: BindSlot(), count: parameters.count)
             for (index, parameter) in parameters.enumerated() {
                 var bind = MYSQL_BIND()
-                setBind(&bind, parameter, columns?[index])
+                setBind(&bind, slot: index, parameter, columns.map { $0[index % $0.count] }, timeConverter)
                 binds.append(bind)
                 bindPtr![index] = bind
             }
         } else { // bind was previously created, re-initialize value
             for (index, parameter) in parameters.enumerated() {
                 var bind = binds[index]
-                setBind(&bind, parameter, columns?[index])
+                setBind(&bind, slot: index, parameter, columns.map { $0[index % $0.count] }, timeConverter)
                 binds[index] = bind
                 bindPtr![index] = bind
             }
@@ -95,6 +222,13 @@ public class MySQLPreparedStatement: PreparedStatement {
         return true
     }
 
+    /// Release the `Data` parameters bound in place by the last execution.
+    internal func releaseParameters() {
+        for index in 0 ..< slots.count {
+            slots[index].borrowed = nil
+        }
+    }
+
     private func deallocateBinds() {
         guard let bindPtr = self.bindPtr else {
             return
@@ -103,13 +237,6 @@ public class MySQLPreparedStatement: PreparedStatement {
         self.bindPtr = nil
 
         for bind in binds {
-            if bind.buffer != nil {
-                #if swift(>=4.1)
-                bind.buffer.deallocate()
-                #else
-                bind.buffer.deallocate(bytes: Int(bind.buffer_length), alignedTo: 1)
-                #endif
-            }
             if bind.length != nil {
                 #if swift(>=4.1)
                 bind.length.deallocate()
@@ -125,165 +252,348 @@ public class MySQLPreparedStatement: PreparedStatement {
                 #endif
             }
         }
+        for slot in slots {
+            // The buffer of a bind may point into a borrowed Data, only the buffers owned by the slots are freed
+            if let buffer = slot.buffer {
+                #if swift(>=4.1)
+                buffer.deallocate()
+                #else
+                buffer.deallocate(bytes: slot.capacity, alignedTo: 1)
+                #endif
+                memory?.released(slot.capacity)
+            }
+        }
         #if swift(>=4.1)
         bindPtr.deallocate()
         #else
         bindPtr.deallocate(capacity: bindsCapacity)
         #endif
         binds.removeAll()
+        slots.removeAll()
     }
 
-    private func setBind(_ bind: inout MYSQL_BIND, _ parameter: Any?, _ column: Column?) {
+    private func setBind(_ bind: inout MYSQL_BIND, slot index: Int, _ parameter: Any?, _ column: Column?, _ timeConverter: MySQLTimeConverter) {
         if bind.is_null == nil {
             bind.is_null = UnsafeMutablePointer<mysql_bool>.allocate(capacity: 1)
         }
 
+        var slot = slots[index]
+        slot.borrowed = nil
+        defer {
+            slots[index] = slot
+        }
+
         guard let parameter = parameter else {
             bind.buffer_type = MYSQL_TYPE_NULL
             bind.is_null.initialize(to: mysql_true())
             return
         }
 
-        bind.buffer_type = getType(parameter: parameter)
-        bind.is_null.initialize(to: mysql_false())
-        bind.is_unsigned = mysql_false()
+        let valueType = ObjectIdentifier(type(of: parameter))
+        if slot.valueType != valueType {
+            // Resolve the kind of value once for each type bound to the slot, later executions skip the type dispatch
+            slot.kind = MySQLPreparedStatement.kind(of: parameter)
+            slot.fieldType = MySQLPreparedStatement.fieldType(of: slot.kind, column)
+            slot.isUnsigned = slot.kind.isUnsigned ? mysql_true() : mysql_false()
+            slot.valueType = valueType
+        }
 
-        switch parameter {
-        case let string as String:
-            initialize(string: string, &bind)
-        case let date as Date:
-            let formatter: DateFormatter
-            switch column?.type {
-            case is SQLDate.Type:
-                formatter = MySQLConnection.dateFormatter
-            case is Time.Type:
-                formatter = MySQLConnection.timeFormatter
-            default:
-                formatter = MySQLConnection.dateTimeFormatter
-            }
-            let formattedDate = formatter.string(from: date)
-            initialize(string: formattedDate, &bind)
-        case let byteArray as [UInt8]:
-            let typedBuffer = allocate(type: UInt8.self, capacity: byteArray.count, bind: &bind)
+        bind.buffer_type = slot.fieldType
+        bind.is_null.initialize(to: mysql_false())
+        bind.is_unsigned = slot.isUnsigned
+
+        switch slot.kind {
+        case .string:
+            initialize(string: parameter as! String, &bind, &slot)
+        case .date:
+            initialize(timeConverter.time(from: parameter as! Date, type: bind.buffer_type), &bind, &slot)
+        case .mysqlDate:
+            initialize((parameter as! MySQLDate).mysqlTime, &bind, &slot)
+        case .mysqlTime:
+            initialize((parameter as! MySQLTime).mysqlTime, &bind, &slot)
+        case .bytes:
+            let byteArray = parameter as! [UInt8]
+            let typedBuffer = allocate(type: UInt8.self, capacity: byteArray.count, bind: &bind, slot: &slot)
             typedBuffer.initialize(from: byteArray, count: byteArray.count)
-        case let data as Data:
-            let typedBuffer = allocate(type: UInt8.self, capacity: data.count, bind: &bind)
-            data.copyBytes(to: typedBuffer, count: data.count)
-        case let dateTime as MYSQL_TIME:
-            initialize(dateTime, &bind)
-        case let float as Float:
-            initialize(float, &bind)
-        case let double as Double:
-            initialize(double, &bind)
-        case let bool as Bool:
-            initialize(bool, &bind)
-        case let int as Int:
-            initialize(int, &bind)
-        case let int as Int8:
-            initialize(int, &bind)
-        case let int as Int16:
-            initialize(int, &bind)
-        case let int as Int32:
-            initialize(int, &bind)
-        case let int as Int64:
-            initialize(int, &bind)
-        case let uint as UInt:
-            initialize(uint, &bind)
-            bind.is_unsigned = mysql_true()
-        case let uint as UInt8:
-            initialize(uint, &bind)
-            bind.is_unsigned = mysql_true()
-        case let uint as UInt16:
-            initialize(uint, &bind)
-            bind.is_unsigned = mysql_true()
-        case let uint as UInt32:
-            initialize(uint, &bind)
-            bind.is_unsigned = mysql_true()
-        case let uint as UInt64:
-            initialize(uint, &bind)
-            bind.is_unsigned = mysql_true()
-        case let unicodeScalar as UnicodeScalar:
-            initialize(unicodeScalar, &bind)
-            bind.is_unsigned = mysql_true()
-        default:
-            print("WARNING: Unhandled parameter \(parameter) (type: \(type(of: parameter))). Will attempt to convert it to a String")
-            initialize(string: String(describing: parameter), &bind)
+        case .data:
+            initialize(data: parameter as! Data, &bind, &slot)
+        case .dateTime:
+            initialize(parameter as! MYSQL_TIME, &bind, &slot)
+        case .float:
+            initialize(parameter as! Float, &bind, &slot)
+        case .double:
+            initialize(parameter as! Double, &bind, &slot)
+        case .bool:
+            initialize(parameter as! Bool, &bind, &slot)
+        case .int:
+            initialize(parameter as! Int, &bind, &slot)
+        case .int8:
+            initialize(parameter as! Int8, &bind, &slot)
+        case .int16:
+            initialize(parameter as! Int16, &bind, &slot)
+        case .int32:
+            initialize(parameter as! Int32, &bind, &slot)
+        case .int64:
+            initialize(parameter as! Int64, &bind, &slot)
+        case .uint:
+            initialize(parameter as! UInt, &bind, &slot)
+        case .uint8:
+            initialize(parameter as! UInt8, &bind, &slot)
+        case .uint16:
+            initialize(parameter as! UInt16, &bind, &slot)
+        case .uint32:
+            initialize(parameter as! UInt32, &bind, &slot)
+        case .uint64:
+            initialize(parameter as! UInt64, &bind, &slot)
+        case .unicodeScalar:
+            initialize(parameter as! UnicodeScalar, &bind, &slot)
+        case .decimal:
+            // DECIMAL parameters are sent as text, the description of a Decimal does not depend on the locale
+            initialize(string: (parameter as! Decimal).description, &bind, &slot)
+        case .other:
+            warn("WARNING: Unhandled parameter \(parameter) (type: \(type(of: parameter))). Will attempt to convert it to a String")
+            initialize(string: String(describing: parameter), &bind, &slot)
         }
     }
 
-    private func allocate<T>(type: T.Type, capacity: Int, bind: inout MYSQL_BIND) -> UnsafeMutablePointer<T> {
-
-        let length = UInt(capacity * MemoryLayout<T>.size)
-
+    private func setLength(_ length: Int, _ bind: inout MYSQL_BIND) {
         if bind.length == nil {
             bind.length = UnsafeMutablePointer<UInt>.allocate(capacity: 1)
         }
-        bind.length.initialize(to: length)
+        bind.length.initialize(to: UInt(length))
+    }
 
-        let typedBuffer: UnsafeMutablePointer<T>
-        if let buffer = bind.buffer, bind.buffer_length >= length {
-            typedBuffer = buffer.assumingMemoryBound(to: type)
-        } else {
-            if bind.buffer != nil {
+    private func allocate<T>(type: T.Type, capacity: Int, bind: inout MYSQL_BIND, slot: inout BindSlot) -> UnsafeMutablePointer<T> {
+
+        let length = capacity * MemoryLayout<T>.size
+        setLength(length, &bind)
+
+        if slot.buffer == nil || slot.capacity < length {
+            if let buffer = slot.buffer {
                 // deallocate existing smaller buffer
                 #if swift(>=4.1)
-                bind.buffer.deallocate()
+                buffer.deallocate()
                 #else
-                bind.buffer.deallocate(bytes: Int(bind.buffer_length), alignedTo: 1)
+                buffer.deallocate(bytes: slot.capacity, alignedTo: 1)
                 #endif
+                memory?.released(slot.capacity)
             }
 
-            typedBuffer = UnsafeMutablePointer<T>.allocate(capacity: capacity)
-            bind.buffer = UnsafeMutableRawPointer(typedBuffer)
-            bind.buffer_length = length
+            slot.buffer = UnsafeMutableRawPointer(UnsafeMutablePointer<T>.allocate(capacity: capacity))
+            slot.capacity = length
+            // Parameter buffers are counted, but not refused, as the statement cannot be executed without them
+            memory?.allocated(length)
         }
 
-        return typedBuffer
+        bind.buffer = slot.buffer
+        bind.buffer_length = UInt(slot.capacity)
+        return slot.buffer!.assumingMemoryBound(to: type)
     }
 
-    private func initialize<T>(_ parameter: T, _ bind: inout MYSQL_BIND) {
-        let typedBuffer = allocate(type: type(of: parameter), capacity: 1, bind: &bind)
+    private func initialize<T>(_ parameter: T, _ bind: inout MYSQL_BIND, _ slot: inout BindSlot) {
+        let typedBuffer = allocate(type: type(of: parameter), capacity: 1, bind: &bind, slot: &slot)
         typedBuffer.initialize(to: parameter)
     }
 
-    private func initialize(string: String, _ bind: inout MYSQL_BIND) {
-        let utf8 = Array(string.utf8)
-        let typedBuffer = allocate(type: UInt8.self, capacity: utf8.count, bind: &bind)
-        typedBuffer.initialize(from: utf8, count: utf8.count)
+    private func initialize(string: String, _ bind: inout MYSQL_BIND, _ slot: inout BindSlot) {
+        let utf8 = string.utf8
+        let typedBuffer = allocate(type: UInt8.self, capacity: utf8.count, bind: &bind, slot: &slot)
+        #if swift(>=5.1)
+        // Copy the contiguous UTF-8 of the string straight into the bind buffer
+        var string = string
+        string.withUTF8 { bytes in
+            if let baseAddress = bytes.baseAddress {
+                typedBuffer.initialize(from: baseAddress, count: bytes.count)
+            }
+        }
+        #else
+        _ = UnsafeMutableBufferPointer(start: typedBuffer, count: utf8.count).initialize(from: utf8)
+        #endif
+    }
+
+    /// Bind the bytes of a `Data` parameter. Those of at least `borrowedDataSize` bytes are bound in place by `execute()`,
+    /// which points the bind to them only while the statement is executed, smaller ones are copied.
+    private func initialize(data: Data, _ bind: inout MYSQL_BIND, _ slot: inout BindSlot) {
+        guard data.count >= MySQLPreparedStatement.borrowedDataSize else {
+            // An empty Data has no bytes to copy, but the bind still gets a buffer of its own
+            let typedBuffer = allocate(type: UInt8.self, capacity: data.count, bind: &bind, slot: &slot)
+            if !data.isEmpty {
+                data.copyBytes(to: typedBuffer, count: data.count)
+            }
+            return
+        }
+
+        slot.borrowed = data
+        setLength(data.count, &bind)
+        bind.buffer = nil
+        bind.buffer_length = UInt(data.count)
+    }
+
+    /// Execute the statement with the parameters bound by `allocateBinds`. The `Data` parameters bound in place
+    /// are only accessed within their `withUnsafeBytes`, so the parameters are bound again to their bytes and sent
+    /// to the server before it returns.
+    ///
+    /// - Returns: The result of `mysql_stmt_execute`, or non-zero if the parameters could not be bound.
+    internal func execute() -> Int32 {
+        guard let statement = statement else {
+            return 1
+        }
+        let borrowed = slots.indices.filter { slots[$0].borrowed != nil }
+        guard !borrowed.isEmpty, let bindPtr = bindPtr else {
+            return mysql_stmt_execute(statement)
+        }
+        return execute(statement, bindPtr: bindPtr, borrowing: borrowed[...])
+    }
+
+    private func execute(_ statement: UnsafeMutablePointer<MYSQL_STMT>, bindPtr: UnsafeMutablePointer<MYSQL_BIND>, borrowing slotIndices: ArraySlice<Int>) -> Int32 {
+        guard let index = slotIndices.first, let data = slots[index].borrowed else {
+            guard mysql_stmt_bind_param(statement, bindPtr) == mysql_false() else {
+                return 1
+            }
+            return mysql_stmt_execute(statement)
+        }
+        #if swift(>=5.0)
+        return data.withUnsafeBytes { (buffer: UnsafeRawBufferPointer) -> Int32 in
+            bindPtr[index].buffer = UnsafeMutableRawPointer(mutating: buffer.baseAddress)
+            defer { bindPtr[index].buffer = nil }
+            return execute(statement, bindPtr: bindPtr, borrowing: slotIndices.dropFirst())
+        }
+        #else
+        return data.withUnsafeBytes { (pointer: UnsafePointer<UInt8>) -> Int32 in
+            bindPtr[index].buffer = UnsafeMutableRawPointer(mutating: pointer)
+            defer { bindPtr[index].buffer = nil }
+            return execute(statement, bindPtr: bindPtr, borrowing: slotIndices.dropFirst())
+        }
+        #endif
     }
 
-    private func getType(parameter: Any) -> enum_field_types {
+    /// The smallest `Data` parameter bound without a copy. Small values may be stored inline in the `Data`,
+    /// where their bytes have no stable address, and are cheaper to copy than to retain.
+    private static let borrowedDataSize = 1024
+
+    private static func kind(of parameter: Any) -> ParameterKind {
         switch parameter {
-        case is String,
-             is Date:
+        case is String:
+            return .string
+        case is Date:
+            return .date
+        case is MySQLDate:
+            return .mysqlDate
+        case is MySQLTime:
+            return .mysqlTime
+        case is [UInt8]:
+            return .bytes
+        case is Data:
+            return .data
+        case is MYSQL_TIME:
+            return .dateTime
+        case is Float:
+            return .float
+        case is Double:
+            return .double
+        case is Bool:
+            return .bool
+        case is Int:
+            return .int
+        case is Int8:
+            return .int8
+        case is Int16:
+            return .int16
+        case is Int32:
+            return .int32
+        case is Int64:
+            return .int64
+        case is UInt:
+            return .uint
+        case is UInt8:
+            return .uint8
+        case is UInt16:
+            return .uint16
+        case is UInt32:
+            return .uint32
+        case is UInt64:
+            return .uint64
+        case is UnicodeScalar:
+            return .unicodeScalar
+        case is Decimal:
+            return .decimal
+        default:
+            return .other
+        }
+    }
+
+    private static func fieldType(of kind: ParameterKind, _ column: Column?) -> enum_field_types {
+        switch kind {
+        case .string,
+             .other:
             return MYSQL_TYPE_STRING
-        case is Data,
-             is [UInt8]:
+        case .data,
+             .bytes:
             return MYSQL_TYPE_BLOB
-        case is Int8,
-             is UInt8,
-             is Bool:
+        case .int8,
+             .uint8,
+             .bool:
             return MYSQL_TYPE_TINY
-        case is Int16,
-             is UInt16:
+        case .int16,
+             .uint16:
             return MYSQL_TYPE_SHORT
-        case is Int32,
-             is UInt32,
-             is UnicodeScalar:
+        case .int32,
+             .uint32,
+             .unicodeScalar:
             return MYSQL_TYPE_LONG
-        case is Int,
-             is UInt,
-             is Int64,
-             is UInt64:
+        case .int,
+             .uint,
+             .int64,
+             .uint64:
             return MYSQL_TYPE_LONGLONG
-        case is Float:
+        case .float:
             return MYSQL_TYPE_FLOAT
-        case is Double:
+        case .double:
             return MYSQL_TYPE_DOUBLE
-        case is MYSQL_TIME:
+        case .date:
+            switch column?.type {
+            case is SQLDate.Type:
+                return MYSQL_TYPE_DATE
+            case is Time.Type:
+                return MYSQL_TYPE_TIME
+            default:
+                return MYSQL_TYPE_DATETIME
+            }
+        case .dateTime:
             return MYSQL_TYPE_DATETIME
+        case .mysqlDate:
+            return MYSQL_TYPE_DATE
+        case .mysqlTime:
+            return MYSQL_TYPE_TIME
+        case .decimal:
+            return MYSQL_TYPE_NEWDECIMAL
+        }
+    }
+}
+
+/// The kind of value bound to a parameter slot.
+private enum ParameterKind {
+    case string, date, mysqlDate, mysqlTime, bytes, data, dateTime, float, double, bool
+    case int, int8, int16, int32, int64, uint, uint8, uint16, uint32, uint64, unicodeScalar, decimal, other
+
+    var isUnsigned: Bool {
+        switch self {
+        case .uint, .uint8, .uint16, .uint32, .uint64, .unicodeScalar:
+            return true
         default:
-            return MYSQL_TYPE_STRING
+            return false
         }
     }
 }
+
+/// The state of a parameter slot kept across executions of a statement: the kind and MySQL type resolved for
+/// the type of its last value, the buffer owned by the slot and the `Data` whose bytes are bound in place.
+private struct BindSlot {
+    var valueType: ObjectIdentifier? = nil
+    var kind = ParameterKind.other
+    var fieldType = MYSQL_TYPE_STRING
+    var isUnsigned = mysql_false()
+    var buffer: UnsafeMutableRawPointer? = nil
+    var capacity = 0
+    var borrowed: Data? = nil
+}
@@ -0,0 +1,85 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+
+/// A least recently used cache of the SQL text built for queries, keyed by a name chosen by the application.
+///
+/// Kuery queries are values without an identity, so a query executed with `MySQLConnection.execute(query:cacheKey:parameters:onCompletion:)`
+/// is built once per key: every query executed with the same key must build to the same SQL. Combined with the statement
+/// cache of the connection, enabled with `statementCacheSize`, repeated executions skip both building and preparing the query.
+/// The built SQL does not depend on the connection, so one cache can be shared by all the connections of a pool.
+public final class MySQLQueryStringCache {
+
+    /// The cache used by connections unless another one is set, holding up to 1000 queries.
+    public static let shared = MySQLQueryStringCache(capacity: 1000)
+
+    private struct Entry {
+        let sql: String
+        var lastUsed: UInt64
+    }
+
+    private var entries = [String: Entry]()
+    private var clock: UInt64 = 0
+    private let lock = NSLock()
+
+    /// The maximum number of queries kept in the cache, 0 disables caching.
+    public let capacity: Int
+
+    /// Initialize an instance of MySQLQueryStringCache.
+    ///
+    /// - Parameter capacity: The maximum number of queries kept in the cache.
+    public init(capacity: Int) {
+        self.capacity = max(capacity, 0)
+    }
+
+    /// Return the SQL cached for `key`, building and caching it with `build` if there is none.
+    ///
+    /// - Parameter key: The key of the query.
+    /// - Parameter build: The function building the SQL of the query.
+    /// - Returns: The SQL of the query.
+    /// - Throws: The error thrown by `build`.
+    public func sql(for key: String, build: () throws -> String) rethrows -> String {
+        lock.lock()
+        clock += 1
+        if let sql = entries[key]?.sql {
+            entries[key]?.lastUsed = clock
+            lock.unlock()
+            return sql
+        }
+        lock.unlock()
+
+        let sql = try build()
+        guard capacity > 0 else {
+            return sql
+        }
+
+        lock.lock()
+        defer { lock.unlock() }
+        if entries[key] == nil && entries.count >= capacity, let oldest = entries.min(by: { $0.value.lastUsed < $1.value.lastUsed }) {
+            entries.removeValue(forKey: oldest.key)
+        }
+        entries[key] = Entry(sql: sql, lastUsed: clock)
+        return sql
+    }
+
+    /// Remove all the queries from the cache.
+    public func removeAll() {
+        lock.lock()
+        defer { lock.unlock() }
+        entries.removeAll()
+    }
+}
@@ -0,0 +1,166 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import CMySQL
+
+/// The output binds of a result set laid out in a single allocation: the `MYSQL_BIND` array, followed by
+/// the lengths, NULL and error flags of the columns, and then the initial buffer of each column.
+///
+/// When a result has been fetched, its arena is kept by the prepared statement and reused by the next
+/// execution of the statement with the same result columns, as for the statements of the statement cache.
+final class MySQLResultBindArena {
+
+    /// The output binds, whose pointers all point into the arena, except for the grown column buffers.
+    let binds: UnsafeMutableBufferPointer<MYSQL_BIND>
+
+    private let memory: UnsafeMutableRawPointer
+    private let byteCount: Int
+    private let metadata: MySQLResultMetadata
+    private let sizes: [Int]
+    private let bufferOffsets: [Int]
+
+    /// The buffers that replaced those of columns with values that did not fit, allocated separately.
+    private var grownBuffers = [Int: UnsafeMutableRawPointer]()
+
+    /// The account of the connection the memory of the arena is counted against.
+    private let account: MySQLMemoryAccount?
+
+    /// The alignment of the column buffers, enough for any of the fixed size values.
+    private static let bufferAlignment = max(MemoryLayout<MYSQL_TIME>.alignment, MemoryLayout<Double>.alignment, MemoryLayout<Int64>.alignment)
+
+    /// Lay out binds for the columns of a result, with initial buffers of the sizes of the columns.
+    init(metadata: MySQLResultMetadata, account: MySQLMemoryAccount? = nil) {
+        let types = metadata.types
+        let sizes = metadata.sizes
+        self.metadata = metadata
+        self.sizes = sizes
+        self.account = account
+
+        let count = types.count
+        var offset = count * MemoryLayout<MYSQL_BIND>.stride
+        let lengthsOffset = MySQLResultBindArena.align(offset, to: MemoryLayout<UInt>.alignment)
+        offset = lengthsOffset + count * MemoryLayout<UInt>.stride
+        let isNullOffset = offset
+        offset += count * MemoryLayout<mysql_bool>.stride
+        let errorOffset = offset
+        offset += count * MemoryLayout<mysql_bool>.stride
+
+        var bufferOffsets = [Int]()
+        bufferOffsets.reserveCapacity(count)
+        for size in sizes {
+            offset = MySQLResultBindArena.align(offset, to: MySQLResultBindArena.bufferAlignment)
+            bufferOffsets.append(offset)
+            offset += size
+        }
+        self.bufferOffsets = bufferOffsets
+
+        byteCount = max(offset, 1)
+        let alignment = max(MemoryLayout<MYSQL_BIND>.alignment, MySQLResultBindArena.bufferAlignment)
+        #if swift(>=4.1)
+        memory = UnsafeMutableRawPointer.allocate(byteCount: byteCount, alignment: alignment)
+        #else
+        memory = UnsafeMutableRawPointer.allocate(bytes: byteCount, alignedTo: alignment)
+        #endif
+
+        let bindPtr = memory.bindMemory(to: MYSQL_BIND.self, capacity: count)
+        let lengths = (memory + lengthsOffset).bindMemory(to: UInt.self, capacity: count)
+        let isNull = (memory + isNullOffset).bindMemory(to: mysql_bool.self, capacity: count)
+        let errors = (memory + errorOffset).bindMemory(to: mysql_bool.self, capacity: count)
+
+        for index in 0 ..< count {
+            var bind = MYSQL_BIND()
+            bind.buffer_type = types[index]
+            bind.buffer_length = UInt(sizes[index])
+            bind.is_unsigned = mysql_false()
+            bind.buffer = memory + bufferOffsets[index]
+
+            (lengths + index).initialize(to: 0)
+            (isNull + index).initialize(to: mysql_false())
+            (errors + index).initialize(to: mysql_false())
+            bind.length = lengths + index
+            bind.is_null = isNull + index
+            bind.error = errors + index
+
+            (bindPtr + index).initialize(to: bind)
+        }
+        binds = UnsafeMutableBufferPointer(start: bindPtr, count: count)
+        account?.allocated(byteCount)
+    }
+
+    deinit {
+        releaseGrownBuffers()
+        account?.released(byteCount)
+        #if swift(>=4.1)
+        memory.deallocate()
+        #else
+        memory.deallocate(bytes: byteCount, alignedTo: max(MemoryLayout<MYSQL_BIND>.alignment, MySQLResultBindArena.bufferAlignment))
+        #endif
+    }
+
+    /// Whether the arena was laid out for the given result columns. The statement keeps its result columns
+    /// until they change, so this is an identity check.
+    func matches(_ metadata: MySQLResultMetadata) -> Bool {
+        return self.metadata === metadata
+    }
+
+    /// Replace the buffer of a column with a separately allocated buffer of `length` bytes.
+    ///
+    /// - Returns: false if the buffer was refused by the memory budget of the connection.
+    func grow(column index: Int, to length: Int) -> Bool {
+        let previousLength = grownBuffers[index] == nil ? 0 : Int(binds[index].buffer_length)
+        if let account = account, !account.reserve(length - previousLength) {
+            return false
+        }
+
+        if let buffer = grownBuffers[index] {
+            #if swift(>=4.1)
+            buffer.deallocate()
+            #else
+            buffer.deallocate(bytes: Int(binds[index].buffer_length), alignedTo: 1)
+            #endif
+        }
+
+        #if swift(>=4.1)
+        let buffer = UnsafeMutableRawPointer.allocate(byteCount: length, alignment: 1)
+        #else
+        let buffer = UnsafeMutableRawPointer.allocate(bytes: length, alignedTo: 1)
+        #endif
+        grownBuffers[index] = buffer
+        binds[index].buffer = buffer
+        binds[index].buffer_length = UInt(length)
+        return true
+    }
+
+    /// Free the grown column buffers, restoring the initial buffers, so that an arena kept for reuse
+    /// does not hold on to the memory of the longest values of its last result.
+    func releaseGrownBuffers() {
+        for (index, buffer) in grownBuffers {
+            account?.released(Int(binds[index].buffer_length))
+            #if swift(>=4.1)
+            buffer.deallocate()
+            #else
+            buffer.deallocate(bytes: Int(binds[index].buffer_length), alignedTo: 1)
+            #endif
+            binds[index].buffer = memory + bufferOffsets[index]
+            binds[index].buffer_length = UInt(sizes[index])
+        }
+        grownBuffers.removeAll()
+    }
+
+    private static func align(_ offset: Int, to alignment: Int) -> Int {
+        return (offset + alignment - 1) / alignment * alignment
+    }
+}
@@ -0,0 +1,49 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import SwiftKuery
+
+/// Whether the rows of a result set are streamed from the server or buffered on the client.
+public enum MySQLResultBuffering {
+    /// The rows are read from the server as they are fetched. The connection cannot be used for other
+    /// operations until the whole result set has been consumed.
+    case streaming
+
+    /// The whole result set is read with `mysql_stmt_store_result` when the statement is executed and the
+    /// prepared statement is released straight away. The connection is free for other operations, or to be
+    /// returned to its pool, while the rows are consumed, and the exact row count is available from
+    /// `MySQLResultFetcher.rowCount`. On a connection with a `MySQLMemoryBudget` the rows are instead read one at a
+    /// time within the budget, so that the client library does not hold a result that exceeds it.
+    case buffered
+
+    /// The results of `Select` queries limited to at most the given number of rows are buffered,
+    /// all other results are streamed.
+    case bufferedUpTo(rows: Int)
+
+    func buffers(_ query: Query?) -> Bool {
+        switch self {
+        case .streaming:
+            return false
+        case .buffered:
+            return true
+        case .bufferedUpTo(let maxRows):
+            guard let select = query as? Select, let rowsToReturn = select.rowsToReturn else {
+                return false
+            }
+            return rowsToReturn <= maxRows
+        }
+    }
+}
@@ -0,0 +1,286 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+import Dispatch
+
+import SwiftKuery
+
+/// A read-through cache of the rows returned by `Select` queries, keyed by the built SQL and the parameters.
+///
+/// When set as the `resultCache` of a connection, `MySQLConnection.execute(query:onCompletion:)` and
+/// `MySQLConnection.execute(query:parameters:onCompletion:)` return the cached rows of a `Select` executed
+/// earlier without using the connection. Entries expire after `timeToLive`, and the least recently used ones
+/// are evicted to keep the rows under `memoryBudget`. An `Insert`, `Update` or `Delete` executed through a connection
+/// using the cache removes the entries of the queries selecting from its table, after the write and again when the
+/// transaction it is part of ends. Writes made with raw SQL, by other clients or by triggers are only seen
+/// when the entries expire, or after `invalidate(table:)` is called.
+///
+/// A result is invalidated by the writes to any table its `Select` reads, including the tables of its joins and subqueries.
+/// Queries are not cached inside transactions, nor are results larger than the memory budget.
+/// One cache can be shared by the connections of a pool, provided they all connect to the same database.
+public final class MySQLResultCache {
+
+    private struct Entry {
+        let titles: [String]
+        let rows: [[Any?]]
+        let tables: [String]
+        let cost: Int
+        let expiresAt: UInt64
+        var lastUsed: UInt64
+    }
+
+    private var entries = [String: Entry]()
+    private var keysByTable = [String: Set<String>]()
+    private var invalidatedAt = [String: UInt64]()
+    private var clock: UInt64 = 0
+    private var totalCost = 0
+    private var hitCount = 0
+    private var missCount = 0
+    private let lock = NSLock()
+
+    /// The time in seconds a result stays in the cache.
+    public let timeToLive: TimeInterval
+
+    /// The estimated number of bytes of the cached rows above which the least recently used results are evicted.
+    public let memoryBudget: Int
+
+    /// Initialize an instance of MySQLResultCache.
+    ///
+    /// - Parameter timeToLive: The time in seconds a result stays in the cache.
+    /// - Parameter memoryBudget: The estimated number of bytes the cached rows may use, defaults to 64MB.
+    public init(timeToLive: TimeInterval, memoryBudget: Int = 64 * 1024 * 1024) {
+        self.timeToLive = max(timeToLive, 0)
+        self.memoryBudget = max(memoryBudget, 0)
+    }
+
+    /// The number of executions answered from the cache.
+    public var hits: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return hitCount
+    }
+
+    /// The number of executions of cacheable queries that had to run on the server.
+    public var misses: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return missCount
+    }
+
+    /// The estimated number of bytes of the cached rows.
+    public var size: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return totalCost
+    }
+
+    /// Remove the results of the queries selecting from a table.
+    ///
+    /// - Parameter table: The table that was modified.
+    public func invalidate(table: Table) {
+        invalidate(tableNamed: table.tableName)
+    }
+
+    /// Remove the results of the queries selecting from a table.
+    ///
+    /// - Parameter name: The name of the table that was modified.
+    public func invalidate(tableNamed name: String) {
+        lock.lock()
+        defer { lock.unlock() }
+        clock += 1
+        // Results read before the invalidation and stored after it are discarded
+        invalidatedAt[name] = clock
+        for key in keysByTable.removeValue(forKey: name) ?? [] {
+            remove(key)
+        }
+    }
+
+    /// Remove all the results from the cache.
+    public func removeAll() {
+        lock.lock()
+        defer { lock.unlock() }
+        clock += 1
+        for name in keysByTable.keys {
+            invalidatedAt[name] = clock
+        }
+        entries.removeAll()
+        keysByTable.removeAll()
+        totalCost = 0
+    }
+
+    /// The key of a query executed with parameters.
+    static func key(sql: String, parameters: [Any?]) -> String {
+        guard !parameters.isEmpty else {
+            return sql
+        }
+        // Each value is prefixed with its type and length, so that distinct parameters never produce the same key
+        var key = sql
+        for parameter in parameters {
+            key += "\u{0}"
+            guard let parameter = parameter else {
+                key += "NULL"
+                continue
+            }
+            let value: String
+            switch parameter {
+            case let data as Data:
+                value = data.base64EncodedString()
+            case let bytes as [UInt8]:
+                value = Data(bytes).base64EncodedString()
+            case let date as Date:
+                value = String(date.timeIntervalSinceReferenceDate.bitPattern)
+            default:
+                value = String(describing: parameter)
+            }
+            key += String(describing: type(of: parameter)) + ":\(value.utf8.count):" + value
+        }
+        return key
+    }
+
+    /// The names of all the tables a `Select` reads: those of its FROM and its joins, and those of the subqueries
+    /// in its fields, filters and common table expressions. These are found by walking the values of the query,
+    /// which is only done when a result is not cached.
+    static func tables(of select: Select) -> [String] {
+        var tables = [String]()
+        var visited = Set<ObjectIdentifier>()
+
+        func collect(_ mirror: Mirror) {
+            for child in mirror.children {
+                collect(child.value)
+            }
+            if let superclassMirror = mirror.superclassMirror {
+                collect(superclassMirror)
+            }
+        }
+
+        func collect(_ value: Any) {
+            let mirror = Mirror(reflecting: value)
+            if mirror.displayStyle == .class {
+                // The columns of a table refer back to it
+                guard visited.insert(ObjectIdentifier(value as AnyObject)).inserted else {
+                    return
+                }
+                if let table = value as? Table, !tables.contains(table.tableName) {
+                    tables.append(table.tableName)
+                }
+            }
+            collect(mirror)
+        }
+
+        for table in select.tables where !tables.contains(table.tableName) {
+            tables.append(table.tableName)
+        }
+        collect(select)
+        return tables
+    }
+
+    /// The current time of the cache, taken before a query runs to detect invalidations made while it runs.
+    var now: UInt64 {
+        lock.lock()
+        defer { lock.unlock() }
+        return clock
+    }
+
+    /// Return the cached result of a query, if there is an unexpired one.
+    func result(for key: String) -> (titles: [String], rows: [[Any?]])? {
+        lock.lock()
+        defer { lock.unlock() }
+        clock += 1
+        guard let entry = entries[key] else {
+            missCount += 1
+            return nil
+        }
+        guard entry.expiresAt > uptime() else {
+            remove(key)
+            missCount += 1
+            return nil
+        }
+        entries[key]?.lastUsed = clock
+        hitCount += 1
+        return (entry.titles, entry.rows)
+    }
+
+    /// Cache the result of a query, unless one of its tables was invalidated since `start` or it is larger than the budget.
+    ///
+    /// - Parameter key: The key of the query.
+    /// - Parameter tables: The names of the tables the query selects from.
+    /// - Parameter titles: The column titles of the result.
+    /// - Parameter rows: The rows of the result.
+    /// - Parameter start: The time of the cache when the query started.
+    func store(_ key: String, tables: [String], titles: [String], rows: [[Any?]], since start: UInt64) {
+        guard timeToLive > 0 else {
+            return
+        }
+        let cost = MySQLResultCache.cost(key: key, titles: titles, rows: rows)
+        guard cost <= memoryBudget else {
+            return
+        }
+
+        lock.lock()
+        defer { lock.unlock() }
+        for table in tables {
+            if let invalidation = invalidatedAt[table], invalidation > start {
+                return
+            }
+        }
+        remove(key)
+        while totalCost + cost > memoryBudget, let oldest = entries.min(by: { $0.value.lastUsed < $1.value.lastUsed }) {
+            remove(oldest.key)
+        }
+
+        clock += 1
+        entries[key] = Entry(titles: titles, rows: rows, tables: tables, cost: cost, expiresAt: uptime() + nanoseconds(timeToLive), lastUsed: clock)
+        totalCost += cost
+        for table in tables {
+            keysByTable[table, default: []].insert(key)
+        }
+    }
+
+    /// Remove an entry. Called with the lock held.
+    private func remove(_ key: String) {
+        guard let entry = entries.removeValue(forKey: key) else {
+            return
+        }
+        totalCost -= entry.cost
+        for table in entry.tables {
+            keysByTable[table]?.remove(key)
+            if keysByTable[table]?.isEmpty == true {
+                keysByTable.removeValue(forKey: table)
+            }
+        }
+    }
+
+    /// An estimate of the memory used by a result: the existentials holding the values, and the bytes of variable length values.
+    private static func cost(key: String, titles: [String], rows: [[Any?]]) -> Int {
+        let valueSize = MemoryLayout<Any?>.stride
+        var cost = key.utf8.count + titles.reduce(0) { $0 + $1.utf8.count + valueSize }
+        for row in rows {
+            cost += 32 + row.count * valueSize
+            for value in row {
+                switch value {
+                case let string as String:
+                    cost += string.utf8.count
+                case let data as Data:
+                    cost += data.count
+                default:
+                    break
+                }
+            }
+        }
+        return cost
+    }
+}
@@ -25,119 +25,216 @@ public class MySQLResultFetcher: ResultFetcher {
 
     private var preparedStatement: MySQLPreparedStatement
     private var bindPtr: UnsafeMutablePointer<MYSQL_BIND>?
-    private var binds: [MYSQL_BIND]
+    private var binds: UnsafeMutableBufferPointer<MYSQL_BIND>
+    private var arena: MySQLResultBindArena?
 
-    private var fieldNames: [String]
-    private var charsetnr: [UInt32]
+    /// The result columns, shared with the prepared statement and its other executions.
+    private var metadata: MySQLResultMetadata
 
     private var hasMoreRows = true
-    
-    private var resultMetadata: UnsafeMutablePointer<MYSQL_RES>? = nil
 
-    init(preparedStatement: MySQLPreparedStatement, resultMetadata: UnsafeMutablePointer<MYSQL_RES>) {
-        self.resultMetadata = resultMetadata
+    private let bufferResults: Bool
+    private var bufferedRows: [[Any?]]? = nil
+    private var bufferedRowIndex = 0
+
+    /// The account the buffers of the result are counted against, the estimated size of the buffered rows,
+    /// and the error returned once the memory budget of the connection has refused a buffer.
+    private let memory: MySQLMemoryAccount?
+    private var bufferedBytes = 0
+    private var fetchError: Error? = nil
+
+    /// The number of rows in the result set. It is only known for results that were buffered on the client,
+    /// see `MySQLResultBuffering`, and is nil for results that are streamed from the server, including the results
+    /// that exceeded the memory budget of the connection while they were buffered.
+    public private(set) var rowCount: Int? = nil
+
+    private static let maxReservedBatchCapacity = 1024
+
+    /// The largest buffer allocated up front for a variable length column. Longer values are fetched with
+    /// `mysql_stmt_fetch_column` into a buffer grown to fit them when a row containing them is read.
+    static let maxInitialBufferSize = 4096
+
+    private var streamedColumns = [Int: StreamedColumn]()
+
+    private let timeConverter: MySQLTimeConverter
+    private let queue: DispatchQueue
+    private let dateAndTimeAsValueTypes: Bool
+    private let decimalDecoding: MySQLDecimalDecoding
+
+    /// The counters of the instrumentation, only updated when the statement has an instrumentation.
+    private let instrumentation: MySQLInstrumentation?
+    private let executedAt: UInt64
+    private var firstRowAt: UInt64? = nil
+    private var fetchNanoseconds: UInt64 = 0
+    private var fetchedRows = 0
+    private var fetchedBytes = 0
+
+    init(preparedStatement: MySQLPreparedStatement, metadata: MySQLResultMetadata, bufferResults: Bool = false, typeOptions: MySQLTypeOptions = MySQLTypeOptions(), queue: DispatchQueue) {
+        self.metadata = metadata
         self.preparedStatement = preparedStatement
-        self.binds = [MYSQL_BIND]()
-        self.fieldNames = [String]()
-        self.charsetnr = [UInt32]()
+        self.bufferResults = bufferResults
+        self.timeConverter = MySQLTimeConverter(timeZone: typeOptions.timeZone)
+        self.dateAndTimeAsValueTypes = typeOptions.dateAndTimeAsValueTypes
+        self.decimalDecoding = typeOptions.decimals
+        self.queue = queue
+        self.memory = preparedStatement.memory
+        self.instrumentation = preparedStatement.instrumentation
+        self.executedAt = preparedStatement.instrumentation == nil ? 0 : uptime()
+        self.binds = UnsafeMutableBufferPointer(start: nil, count: 0)
     }
 
     internal func initialize() -> Bool {
-        guard let fields = mysql_fetch_fields(resultMetadata) else {
+        guard preparedStatement.execute() == 0 else {
             return initError(preparedStatement)
         }
 
-        let numFields = Int(mysql_num_fields(resultMetadata))
-        var binds = [MYSQL_BIND]()
-        var fieldNames = [String]()
-        var charsetnr = [UInt32]()
-
-        for i in 0 ..< numFields {
-            let field = fields[i]
-            binds.append(MySQLResultFetcher.getOutputBind(field))
-            fieldNames.append(String(cString: field.name))
-            charsetnr.append(field.charsetnr)
+        // The result columns read by an earlier execution are only read again if the server re-prepared the statement
+        guard let metadata = preparedStatement.refreshResultMetadata(metadata) else {
+            return initError(preparedStatement)
         }
-
-        let bindPtr = UnsafeMutablePointer<MYSQL_BIND>.allocate(capacity: binds.count)
-        for i in 0 ..< binds.count {
-            bindPtr[i] = binds[i]
+        self.metadata = metadata
+
+        // Reuse the binds of the previous execution of the statement if it returned the same columns
+        let arena: MySQLResultBindArena
+        if let previous = preparedStatement.resultArena, previous.matches(metadata) {
+            arena = previous
+        } else {
+            arena = MySQLResultBindArena(metadata: metadata, account: memory)
         }
+        preparedStatement.resultArena = nil
+        let bindPtr = arena.binds.baseAddress
 
         guard mysql_stmt_bind_result(preparedStatement.statement, bindPtr) == mysql_false() else {
-            return initError(preparedStatement, bindPtr: bindPtr, binds: binds)
+            return initError(preparedStatement)
         }
 
-        guard mysql_stmt_execute(preparedStatement.statement) == 0 else {
-            return initError(preparedStatement, bindPtr: bindPtr, binds: binds)
+        // Under a memory budget the rows are read one at a time as they are buffered, rather than all stored by
+        // the client library first, so that a result exceeding the budget never gets all its rows in memory
+        if bufferResults && memory?.budget == nil {
+            guard mysql_stmt_store_result(preparedStatement.statement) == 0 else {
+                return initError(preparedStatement)
+            }
+            rowCount = Int(mysql_stmt_num_rows(preparedStatement.statement))
         }
 
+        self.arena = arena
         self.bindPtr = bindPtr
-        self.binds = binds
-        self.fieldNames = fieldNames
-        self.charsetnr = charsetnr
+        self.binds = arena.binds
+
+        if bufferResults {
+            bufferRows()
+        }
 
         return true
     }
 
-    deinit {
-        close()
+    /// Decode all the rows of a result and release the prepared statement, so that the connection is free to be used
+    /// for other operations while the rows are consumed. Each row is reserved in the memory budget of the connection,
+    /// if it has one, as it is read from the server. When the rows exceed the budget, the rows decoded so far are kept
+    /// and the others are read from the server as they are fetched, or, under the `.fail` policy, fetching the rows fails
+    /// and the rows are discarded, the rows not read being discarded by the client library when the statement is released.
+    private func bufferRows() {
+        let start = instrumentation == nil ? 0 : uptime()
+        var rows = [[Any?]]()
+        rows.reserveCapacity(rowCount ?? 0)
+        var withinBudget = true
+        while let row = buildRow() {
+            if let memory = memory {
+                let size = rowSize()
+                guard memory.reserveBuffer(size) else {
+                    memoryLimitExceeded()
+                    if memory.policy == .fail {
+                        fetchError = memory.limitError(reserving: size)
+                    } else {
+                        memory.allocated(size)
+                        bufferedBytes += size
+                        rows.append(row)
+                    }
+                    withinBudget = false
+                    break
+                }
+                bufferedBytes += size
+            }
+            rows.append(row)
+        }
+        if instrumentation != nil {
+            fetchNanoseconds += uptime() - start
+        }
+        if fetchError != nil {
+            // Under the `.fail` policy none of the rows are returned
+            rows = []
+            memory?.released(bufferedBytes)
+            bufferedBytes = 0
+        }
+        bufferedRows = rows
+        if withinBudget && rowCount == nil {
+            rowCount = rows.count
+        }
+        if withinBudget || fetchError != nil {
+            hasMoreRows = false
+            close()
+        }
     }
 
-    private func initError(_ preparedStatement: MySQLPreparedStatement, bindPtr: UnsafeMutablePointer<MYSQL_BIND>? = nil, binds: [MYSQL_BIND]? = nil) -> Bool {
-
-        if let binds = binds {
-            for bind in binds {
-                
-                #if swift(>=4.1)
-                bind.buffer.deallocate()
-                bind.length.deallocate()
-                bind.is_null.deallocate()
-                bind.error.deallocate()
-                #else
-                bind.buffer.deallocate(bytes: Int(bind.buffer_length), alignedTo: 1)
-                bind.length.deallocate(capacity: 1)
-                bind.is_null.deallocate(capacity: 1)
-                bind.error.deallocate(capacity: 1)
-                #endif
-            }
+    /// The estimated memory used by the current row once decoded: the existentials holding the values and the bytes of the values.
+    private func rowSize() -> Int {
+        var size = 32 + binds.count * MemoryLayout<Any?>.stride
+        for bind in binds where bind.is_null.pointee == mysql_false() {
+            size += getLength(bind)
+        }
+        return size
+    }
 
-            if let bindPtr = bindPtr {
-                #if swift(>=4.1)
-                bindPtr.deallocate()
-                #else
-                bindPtr.deallocate(capacity: binds.count)
-                #endif
-            }
+    /// Report to the instrumentation that a buffer was refused by the memory budget.
+    private func memoryLimitExceeded() {
+        if let instrumentation = instrumentation, let memory = memory {
+            instrumentation.didUseMemory(memory.usage(limitExceeded: true))
         }
+    }
+
+    /// Free the buffered rows, when they have been consumed, or the rows that did not fit are to be streamed.
+    private func releaseBufferedRows() {
+        if bufferedRows != nil {
+            bufferedRows = nil
+            memory?.released(bufferedBytes)
+            bufferedBytes = 0
+        }
+    }
+
+    deinit {
+        close()
+        memory?.released(bufferedBytes)
+    }
+
+    private func initError(_ preparedStatement: MySQLPreparedStatement) -> Bool {
+        // The binds are freed with their arena
         return false
     }
 
     private func close() {
-        if let bindPtr = bindPtr {
+        if let _ = bindPtr {
             self.bindPtr = nil
 
-            for bind in binds {
-                #if swift(>=4.1)
-                bind.buffer.deallocate()
-                bind.length.deallocate()
-                bind.is_null.deallocate()
-                bind.error.deallocate()
-                #else
-                bind.buffer.deallocate(bytes: Int(bind.buffer_length), alignedTo: 1)
-                bind.length.deallocate(capacity: 1)
-                bind.is_null.deallocate(capacity: 1)
-                bind.error.deallocate(capacity: 1)
-                #endif
+            let arena = self.arena
+            self.arena = nil
+            binds = UnsafeMutableBufferPointer(start: nil, count: 0)
+            if let instrumentation = instrumentation {
+                let firstRow = firstRowAt.map { seconds(from: executedAt, to: $0) }
+                instrumentation.didFetch(MySQLFetchMetrics(sql: preparedStatement.sql, timeToFirstRow: firstRow, fetch: TimeInterval(fetchNanoseconds) / 1_000_000_000, rowCount: fetchedRows, bytesReceived: fetchedBytes))
+                if let memory = memory {
+                    instrumentation.didUseMemory(memory.usage())
+                }
+            }
+            // Done may be called from any thread, the statement is only reset on the queue of the connection
+            let preparedStatement = self.preparedStatement
+            let unread = hasMoreRows || fetchError != nil
+            preparedStatement.onConnectionQueue {
+                preparedStatement.hasUnreadResult = unread
+                // Keep the binds for the next execution, they are freed if the statement is closed by its release
+                arena?.releaseGrownBuffers()
+                preparedStatement.resultArena = arena
+                preparedStatement.release() { _ in }
             }
-            #if swift(>=4.1)
-            bindPtr.deallocate()
-            #else
-            bindPtr.deallocate(capacity: binds.count)
-            #endif
-
-            mysql_free_result(resultMetadata)
-            preparedStatement.release() { _ in }
         }
     }
 
@@ -145,61 +242,201 @@ public class MySQLResultFetcher: ResultFetcher {
     ///
     public func done() {
         close()
+        if bufferedRows != nil {
+            releaseBufferedRows()
+            bufferedRows = []
+        }
+    }
+
+    /// Stop fetching the rows of the result, discarding the rows that have not been read, and release the statement.
+    /// A result read through a server side cursor, see `MySQLPreparedStatement.cursorPrefetchRows`, is closed on the
+    /// server without sending the remaining rows. The remaining rows of a result streamed without a cursor are still
+    /// received by `mysql_stmt_free_result`, but they are not decoded. This function is non-blocking.
+    public func cancel() {
+        queue.async {
+            MySQLThread.initialize()
+            if self.hasMoreRows, let _ = self.bindPtr, let statement = self.preparedStatement.statement {
+                mysql_stmt_free_result(statement)
+                _ = mysql_stmt_reset(statement)
+            }
+            self.hasMoreRows = false
+            self.done()
+        }
     }
 
     /// Fetch the next row of the query result. This function is non-blocking.
     ///
     /// - Parameter callback: A callback to call when the next row of the query result is ready.
     public func fetchNext(callback: @escaping (([Any?]?, Error?)) -> ()) {
-        DispatchQueue.global().async {
-            mysql_thread_init()
+        fetchNext(batchSize: 1) { batch in
+            callback((batch.0?.first, batch.1))
+        }
+    }
+
+    /// Fetch the next rows of the query result. This function is non-blocking.
+    /// Up to `batchSize` rows are fetched and decoded in a single asynchronous operation,
+    /// which is considerably cheaper than fetching a large result one row at a time.
+    ///
+    /// - Parameter batchSize: The maximum number of rows to fetch.
+    /// - Parameter callback: A callback to call when the next rows of the query result are ready. The rows are nil when there are no more rows.
+    public func fetchNext(batchSize: Int, callback: @escaping (([[Any?]]?, Error?)) -> ()) {
+        let maxRows = max(batchSize, 1)
+        queue.async {
+            if let bufferedRows = self.bufferedRows {
+                let start = self.bufferedRowIndex
+                let end = start + min(maxRows, bufferedRows.count - start)
+                if end > start {
+                    self.bufferedRowIndex = end
+                    return callback((Array(bufferedRows[start ..< end]), nil))
+                }
+                // The buffered rows have been consumed, the rows that did not fit in the memory budget,
+                // if any, are read from the server
+                self.releaseBufferedRows()
+            }
+
+            MySQLThread.initialize()
             guard self.hasMoreRows else {
-                mysql_thread_end()
-                return callback((nil, nil))
+                return callback((nil, self.fetchError))
             }
 
-            if let row = self.buildRow() {
-                mysql_thread_end()
-                return callback((row, nil))
-            } else {
-                self.hasMoreRows = false
-                self.close()
-                mysql_thread_end()
-                return callback((nil, nil))
+            let start = self.instrumentation == nil ? 0 : uptime()
+            var rows = [[Any?]]()
+            rows.reserveCapacity(min(maxRows, MySQLResultFetcher.maxReservedBatchCapacity))
+            while rows.count < maxRows {
+                guard let row = self.buildRow() else {
+                    self.recordFetch(since: start)
+                    self.hasMoreRows = false
+                    self.close()
+                    break
+                }
+                rows.append(row)
+            }
+            if self.hasMoreRows {
+                self.recordFetch(since: start)
             }
+            guard !rows.isEmpty else {
+                return callback((nil, self.fetchError))
+            }
+            return callback((rows, nil))
         }
     }
 
-    /// Fetch the titles of the query result. This function is non-blocking.
-    ///
-    /// - Parameter callback: A closure that accepts a tuple containing an optional array of column titles of type String and an optional Error
-    public func fetchTitles(callback: @escaping (([String]?, Error?)) -> ()) {
-        // As the titles are prepared during intialisation we can return without needing to offload.
-        return callback((fieldNames, nil))
+    /// Fetch all the remaining rows of the query result on the calling thread, which must be running on the queue of the connection.
+    func fetchAllOnCurrentThread() -> [[Any?]] {
+        var rows = [[Any?]]()
+        if let bufferedRows = bufferedRows {
+            rows = Array(bufferedRows[bufferedRowIndex...])
+            bufferedRowIndex = bufferedRows.count
+            guard hasMoreRows else {
+                return rows
+            }
+            releaseBufferedRows()
+        }
+
+        MySQLThread.initialize()
+        let start = instrumentation == nil ? 0 : uptime()
+        while hasMoreRows, let row = buildRow() {
+            rows.append(row)
+        }
+        if hasMoreRows {
+            recordFetch(since: start)
+            hasMoreRows = false
+            close()
+        }
+        return rows
     }
 
-    private static func getOutputBind(_ field: MYSQL_FIELD) -> MYSQL_BIND {
-        let size = getSize(field: field)
+    /// Fetch the next rows of the query result decoded into typed column storage. This function is non-blocking.
+    /// Decoding into a `MySQLColumnBatch` avoids boxing every value into an `Any` and allocating a `String`
+    /// for every string value, which dominates the cost of decoding large results of numeric columns.
+    ///
+    /// - Parameter batchSize: The maximum number of rows to fetch.
+    /// - Parameter batch: A batch returned by a previous call, whose storage is reused for the new rows.
+    /// - Parameter callback: A callback to call when the next rows of the query result are ready. The batch is nil when there are no more rows.
+    public func fetchColumns(batchSize: Int, reusing batch: MySQLColumnBatch? = nil, callback: @escaping ((MySQLColumnBatch?, Error?)) -> ()) {
+        let maxRows = max(batchSize, 1)
+
+        queue.async {
+            var batch = batch ?? MySQLColumnBatch(kinds: self.columnKinds())
+            batch.removeAll()
+
+            if let bufferedRows = self.bufferedRows {
+                let start = self.bufferedRowIndex
+                let end = start + min(maxRows, bufferedRows.count - start)
+                if end > start {
+                    for row in bufferedRows[start ..< end] {
+                        for (index, value) in row.enumerated() {
+                            batch.columns[index].append(value: value, scale: self.metadata.scales[index])
+                        }
+                    }
+                    batch.rowCount = end - start
+                    self.bufferedRowIndex = end
+                    return callback((batch, nil))
+                }
+                self.releaseBufferedRows()
+            }
 
-        var bind = MYSQL_BIND()
-        bind.buffer_type = field.type
-        bind.buffer_length = UInt(size)
-        bind.is_unsigned = mysql_false()
+            MySQLThread.initialize()
+            guard self.hasMoreRows else {
+                return callback((nil, self.fetchError))
+            }
 
-        #if swift(>=4.1)
-        bind.buffer = UnsafeMutableRawPointer.allocate(byteCount: size, alignment: 1)
-        #else
-        bind.buffer = UnsafeMutableRawPointer.allocate(bytes: size, alignedTo: 1)
-        #endif
-        
-        bind.length = UnsafeMutablePointer<UInt>.allocate(capacity: 1)
-        bind.is_null = UnsafeMutablePointer<mysql_bool>.allocate(capacity: 1)
-        bind.error = UnsafeMutablePointer<mysql_bool>.allocate(capacity: 1)
+            let start = self.instrumentation == nil ? 0 : uptime()
+            while batch.rowCount < maxRows {
+                guard self.fetchRow(), self.appendRow(to: &batch) else {
+                    self.recordFetch(since: start)
+                    self.hasMoreRows = false
+                    self.close()
+                    break
+                }
+                batch.rowCount += 1
+            }
+            if self.hasMoreRows {
+                self.recordFetch(since: start)
+            }
+            guard batch.rowCount > 0 else {
+                return callback((nil, self.fetchError))
+            }
+            return callback((batch, nil))
+        }
+    }
+
+    /// The kinds of the columns of a batch, from the result columns rather than the binds,
+    /// which are released once the rows of a buffered result have been decoded.
+    private func columnKinds() -> [MySQLColumnValues.Kind] {
+        return (0 ..< metadata.count).map { index in
+            streamedColumns[index] != nil ? .integer : MySQLColumnValues.kind(of: metadata.types[index], charsetnr: metadata.charsetnr[index])
+        }
+    }
+
+    private func appendRow(to batch: inout MySQLColumnBatch) -> Bool {
+        for (index, bind) in binds.enumerated() {
+            if !streamedColumns.isEmpty, let streamedColumn = streamedColumns[index] {
+                guard bind.is_null.pointee == mysql_false() else {
+                    batch.columns[index].append(streamedLength: nil)
+                    continue
+                }
+                guard let length = streamValue(ofColumn: index, to: streamedColumn) else {
+                    preparedStatement.warn("ERROR: while streaming column \(index): \(preparedStatement.getError(preparedStatement.statement!))")
+                    return false
+                }
+                batch.columns[index].append(streamedLength: length)
+                continue
+            }
+            batch.columns[index].append(bind, length: getLength(bind), timeConverter: timeConverter)
+        }
+        return true
+    }
 
-        return bind
+    /// Fetch the titles of the query result. This function is non-blocking.
+    ///
+    /// - Parameter callback: A closure that accepts a tuple containing an optional array of column titles of type String and an optional Error
+    public func fetchTitles(callback: @escaping (([String]?, Error?)) -> ()) {
+        // The names are read from the result metadata held on the client, without needing to offload.
+        return callback((metadata.titles, nil))
     }
 
-    private static func getSize(field: MYSQL_FIELD) -> Int {
+    static func getSize(field: MYSQL_FIELD) -> Int {
         switch field.type {
         case MYSQL_TYPE_TINY:
             return MemoryLayout<Int8>.size
@@ -220,23 +457,55 @@ public class MySQLResultFetcher: ResultFetcher {
              MYSQL_TYPE_TIMESTAMP:
             return MemoryLayout<MYSQL_TIME>.size
         default:
-            return Int(field.length)
+            // field.length is the maximum length of the column, which is up to 4GB for LONGBLOB and LONGTEXT
+            return min(Int(field.length), maxInitialBufferSize)
         }
     }
 
-    private func buildRow() -> [Any?]? {
+    /// Fetch the next row into the output binds.
+    ///
+    /// - Returns: false if there are no more rows or the row could not be fetched.
+    private func fetchRow() -> Bool {
         let fetchStatus = mysql_stmt_fetch(preparedStatement.statement)
         if fetchStatus == MYSQL_NO_DATA {
-            return nil
+            return false
         }
 
-        if fetchStatus == 1 {
+        if fetchStatus == 1 || (fetchStatus == MYSQL_DATA_TRUNCATED && !fetchTruncatedColumns()) {
+            guard fetchError == nil else {
+                // A value did not fit in the memory budget, the error is returned by the fetch
+                return false
+            }
             // use a logger or add throws to the fetchNext signature?
-            print("ERROR: while fetching row: \(preparedStatement.getError(preparedStatement.statement!))")
+            preparedStatement.warn("ERROR: while fetching row: \(preparedStatement.getError(preparedStatement.statement!))")
+            return false
+        }
+        if instrumentation != nil {
+            if firstRowAt == nil {
+                firstRowAt = uptime()
+            }
+            fetchedRows += 1
+            for bind in binds where bind.is_null.pointee == mysql_false() {
+                fetchedBytes += Int(bind.length.pointee)
+            }
+        }
+        return true
+    }
+
+    private func recordFetch(since start: UInt64) {
+        if instrumentation != nil {
+            fetchNanoseconds += uptime() - start
+        }
+    }
+
+    private func buildRow() -> [Any?]? {
+        guard fetchRow() else {
             return nil
         }
 
+        let decoders = metadata.decoders
         var row = [Any?]()
+        row.reserveCapacity(binds.count)
         for (index, bind) in binds.enumerated() {
             guard let buffer = bind.buffer else {
                 row.append("bind buffer not set")
@@ -248,64 +517,166 @@ public class MySQLResultFetcher: ResultFetcher {
                 continue
             }
 
-            let type = bind.buffer_type
-            switch type {
-            case MYSQL_TYPE_TINY:
+            if !streamedColumns.isEmpty, let streamedColumn = streamedColumns[index] {
+                guard let length = streamValue(ofColumn: index, to: streamedColumn) else {
+                    preparedStatement.warn("ERROR: while streaming column \(index): \(preparedStatement.getError(preparedStatement.statement!))")
+                    return nil
+                }
+                row.append(length)
+                continue
+            }
+
+            // The decoding of each column is chosen once, when the result columns are read
+            switch decoders[index] {
+            case .int8:
                 row.append(buffer.load(as: Int8.self))
-            case MYSQL_TYPE_SHORT:
+            case .int16:
                 row.append(buffer.load(as: Int16.self))
-            case MYSQL_TYPE_INT24,
-                 MYSQL_TYPE_LONG:
+            case .int32:
                 row.append(buffer.load(as: Int32.self))
-            case MYSQL_TYPE_LONGLONG:
+            case .int64:
                 row.append(buffer.load(as: Int64.self))
-            case MYSQL_TYPE_FLOAT:
+            case .float:
                 row.append(buffer.load(as: Float.self))
-            case MYSQL_TYPE_DOUBLE:
+            case .double:
                 row.append(buffer.load(as: Double.self))
-            case MYSQL_TYPE_NEWDECIMAL,
-                 MYSQL_TYPE_STRING,
-                 MYSQL_TYPE_VAR_STRING:
-                row.append(String(bytesNoCopy: buffer, length: getLength(bind), encoding: .utf8, freeWhenDone: false))
-            case MYSQL_TYPE_TINY_BLOB,
-                 MYSQL_TYPE_BLOB,
-                 MYSQL_TYPE_MEDIUM_BLOB,
-                 MYSQL_TYPE_LONG_BLOB:
-                if charsetnr[index] == 63 {
-                  // Value 63 is used to denote binary data
-                  // see https://dev.mysql.com/doc/refman/5.7/en/c-api-prepared-statement-type-conversions.html
-                  row.append(Data(bytes: buffer, count: getLength(bind)))
-                } else { 
-                  // We are assuming that the returned data
-                  // is encoded in UTF-8
-                  row.append(String(bytesNoCopy: buffer, length: getLength(bind), encoding: .utf8, freeWhenDone: false))
+            case .decimal:
+                if decimalDecoding == .string {
+                    row.append(String(decoding: UnsafeRawBufferPointer(start: buffer, count: getLength(bind)), as: UTF8.self))
+                } else {
+                    let bytes = UnsafeBufferPointer(start: buffer.assumingMemoryBound(to: UInt8.self), count: getLength(bind))
+                    row.append(MySQLDecimalConverter.decode(bytes, as: decimalDecoding, scale: metadata.scales[index]))
                 }
-            case MYSQL_TYPE_BIT:
+            case .text:
+                // We are assuming that the returned data is encoded in UTF-8. It is copied out of the bind buffer,
+                // which is overwritten by the next row.
+                row.append(String(decoding: UnsafeRawBufferPointer(start: buffer, count: getLength(bind)), as: UTF8.self))
+            case .binary:
                 row.append(Data(bytes: buffer, count: getLength(bind)))
-            case MYSQL_TYPE_TIME:
-                let time = buffer.load(as: MYSQL_TIME.self)
-                row.append("\(pad(time.hour)):\(pad(time.minute)):\(pad(time.second))")
-            case MYSQL_TYPE_DATE:
+            case .time:
                 let time = buffer.load(as: MYSQL_TIME.self)
-                row.append("\(time.year)-\(pad(time.month))-\(pad(time.day))")
-            case MYSQL_TYPE_DATETIME,
-                 MYSQL_TYPE_TIMESTAMP:
+                if dateAndTimeAsValueTypes {
+                    row.append(MySQLTime(time))
+                } else {
+                    row.append(MySQLTimeConverter.timeString(time))
+                }
+            case .date:
                 let time = buffer.load(as: MYSQL_TIME.self)
-                let formattedDate = "\(time.year)-\(time.month)-\(time.day) \(time.hour):\(time.minute):\(time.second)"
-                row.append(MySQLConnection.dateTimeFormatter.date(from: formattedDate))
-            default:
-                print("Using string for unhandled enum_field_type: \(type.rawValue)")
-                row.append(String(bytesNoCopy: buffer, length: getLength(bind), encoding: .utf8, freeWhenDone: false))
+                if dateAndTimeAsValueTypes {
+                    row.append(MySQLDate(time))
+                } else {
+                    row.append(MySQLTimeConverter.dateString(time))
+                }
+            case .dateTime:
+                row.append(timeConverter.date(from: buffer.load(as: MYSQL_TIME.self)))
+            case .unhandled:
+                preparedStatement.warn("Using string for unhandled enum_field_type: \(bind.buffer_type.rawValue)")
+                row.append(String(decoding: UnsafeRawBufferPointer(start: buffer, count: getLength(bind)), as: UTF8.self))
             }
         }
         return row
     }
 
+    /// Fetch the values of the current row that did not fit in their column buffers,
+    /// growing the buffers so that they also fit values of the same length in later rows.
+    private func fetchTruncatedColumns() -> Bool {
+        guard let statement = preparedStatement.statement, let bindPtr = bindPtr else {
+            return false
+        }
+
+        var rebind = false
+        for index in 0 ..< binds.count where binds[index].error.pointee != mysql_false() && streamedColumns[index] == nil {
+            let length = Int(binds[index].length.pointee)
+            guard length > Int(binds[index].buffer_length) else {
+                continue
+            }
+
+            if let arena = arena, !arena.grow(column: index, to: length) {
+                memoryLimitExceeded()
+                fetchError = memory?.limitError(reserving: length)
+                return false
+            }
+
+            guard mysql_stmt_fetch_column(statement, bindPtr + index, UInt32(index), 0) == 0 else {
+                return false
+            }
+            rebind = true
+        }
+
+        // Use the grown buffers for the following rows
+        return !rebind || mysql_stmt_bind_result(statement, bindPtr) == mysql_false()
+    }
+
+    /// Stream the values of a column to `sink` in chunks instead of returning them in the rows.
+    /// The value of the column in the fetched rows is the length in bytes of the value that has been streamed,
+    /// as an `Int`, or nil if it was NULL. The sink is called with the consecutive chunks of each value, on the
+    /// thread fetching the row, before the row itself is returned. A chunk is only valid for the duration of the call.
+    /// This must be called before the rows are fetched, and has no effect on results buffered on the client.
+    ///
+    /// - Parameter column: The index of the column to stream.
+    /// - Parameter chunkSize: The maximum number of bytes passed to the sink at a time.
+    /// - Parameter sink: The function to be called with each chunk of the values in the column.
+    public func stream(column: Int, chunkSize: Int = 64 * 1024, to sink: @escaping (UnsafeRawBufferPointer) -> ()) {
+        guard column >= 0 && column < metadata.count else {
+            preparedStatement.warn("WARNING: Cannot stream column \(column), the result set has \(metadata.count) columns")
+            return
+        }
+        streamedColumns[column] = StreamedColumn(type: metadata.types[column], chunkSize: max(chunkSize, 1), sink: sink)
+    }
+
+    private func streamValue(ofColumn index: Int, to streamedColumn: StreamedColumn) -> Int? {
+        guard let statement = preparedStatement.statement else {
+            return nil
+        }
+
+        let length = Int(binds[index].length.pointee)
+        var offset = 0
+        while offset < length {
+            guard mysql_stmt_fetch_column(statement, &streamedColumn.bind, UInt32(index), UInt(offset)) == 0 else {
+                return nil
+            }
+            let count = min(length - offset, Int(streamedColumn.bind.buffer_length))
+            streamedColumn.sink(UnsafeRawBufferPointer(start: streamedColumn.bind.buffer, count: count))
+            offset += count
+        }
+        return length
+    }
+
     private func getLength(_ bind: MYSQL_BIND) -> Int {
         return Int(bind.length.pointee > bind.buffer_length ? bind.buffer_length : bind.length.pointee)
     }
+}
+
+/// The chunk buffer and sink of a column streamed by `MySQLResultFetcher.stream(column:chunkSize:to:)`.
+private final class StreamedColumn {
+    var bind = MYSQL_BIND()
+    let sink: (UnsafeRawBufferPointer) -> ()
 
-    private func pad(_ uInt: UInt32) -> String {
-        return String(format: "%02u", uInt)
+    init(type: enum_field_types, chunkSize: Int, sink: @escaping (UnsafeRawBufferPointer) -> ()) {
+        self.sink = sink
+        bind.buffer_type = type
+        bind.buffer_length = UInt(chunkSize)
+        #if swift(>=4.1)
+        bind.buffer = UnsafeMutableRawPointer.allocate(byteCount: chunkSize, alignment: 1)
+        #else
+        bind.buffer = UnsafeMutableRawPointer.allocate(bytes: chunkSize, alignedTo: 1)
+        #endif
+        bind.length = UnsafeMutablePointer<UInt>.allocate(capacity: 1)
+        bind.is_null = UnsafeMutablePointer<mysql_bool>.allocate(capacity: 1)
+        bind.error = UnsafeMutablePointer<mysql_bool>.allocate(capacity: 1)
+    }
+
+    deinit {
+        #if swift(>=4.1)
+        bind.buffer.deallocate()
+        bind.length.deallocate()
+        bind.is_null.deallocate()
+        bind.error.deallocate()
+        #else
+        bind.buffer.deallocate(bytes: Int(bind.buffer_length), alignedTo: 1)
+        bind.length.deallocate(capacity: 1)
+        bind.is_null.deallocate(capacity: 1)
+        bind.error.deallocate(capacity: 1)
+        #endif
     }
 }
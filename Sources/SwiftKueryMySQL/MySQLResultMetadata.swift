@@ -0,0 +1,170 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+
+import CMySQL
+
+/// How the value of a column is decoded from its output bind into a row.
+enum MySQLColumnDecoder {
+    case int8
+    case int16
+    case int32
+    case int64
+    case float
+    case double
+    case decimal
+    case text
+    case binary
+    case time
+    case date
+    case dateTime
+    /// A type without a specific decoding, returned as a string with a warning.
+    case unhandled
+
+    init(type: enum_field_types, charsetnr: UInt32) {
+        switch type {
+        case MYSQL_TYPE_TINY:
+            self = .int8
+        case MYSQL_TYPE_SHORT:
+            self = .int16
+        case MYSQL_TYPE_INT24,
+             MYSQL_TYPE_LONG:
+            self = .int32
+        case MYSQL_TYPE_LONGLONG:
+            self = .int64
+        case MYSQL_TYPE_FLOAT:
+            self = .float
+        case MYSQL_TYPE_DOUBLE:
+            self = .double
+        case MYSQL_TYPE_NEWDECIMAL:
+            self = .decimal
+        case MYSQL_TYPE_STRING,
+             MYSQL_TYPE_VAR_STRING:
+            self = .text
+        case MYSQL_TYPE_TINY_BLOB,
+             MYSQL_TYPE_BLOB,
+             MYSQL_TYPE_MEDIUM_BLOB,
+             MYSQL_TYPE_LONG_BLOB:
+            // Value 63 is used to denote binary data
+            // see https://dev.mysql.com/doc/refman/5.7/en/c-api-prepared-statement-type-conversions.html
+            self = charsetnr == 63 ? .binary : .text
+        case MYSQL_TYPE_BIT:
+            self = .binary
+        case MYSQL_TYPE_TIME:
+            self = .time
+        case MYSQL_TYPE_DATE:
+            self = .date
+        case MYSQL_TYPE_DATETIME,
+             MYSQL_TYPE_TIMESTAMP:
+            self = .dateTime
+        default:
+            self = .unhandled
+        }
+    }
+}
+
+/// The result columns of a prepared statement, decoded once from its result set metadata and kept by the statement
+/// for its later executions. The bytes of the column names are copied, as the fields of the metadata are freed with
+/// the statement, and the names are only created from them when the titles of a result are requested.
+final class MySQLResultMetadata {
+
+    let types: [enum_field_types]
+    let sizes: [Int]
+    let charsetnr: [UInt32]
+    let scales: [Int]
+    let decoders: [MySQLColumnDecoder]
+
+    /// The UTF-8 bytes of the column names, one after the other, and the offset at which each name ends.
+    private let nameBytes: [UInt8]
+    private let nameEnds: [Int]
+    private var names: [String]? = nil
+    private let lock = NSLock()
+
+    /// Read the result columns of a statement.
+    ///
+    /// - Returns: nil if the statement does not return a result set.
+    init?(statement: UnsafeMutablePointer<MYSQL_STMT>) {
+        guard let result = mysql_stmt_result_metadata(statement) else {
+            return nil
+        }
+        guard let fields = mysql_fetch_fields(result) else {
+            mysql_free_result(result)
+            return nil
+        }
+
+        let count = Int(mysql_num_fields(result))
+        var types = [enum_field_types]()
+        var sizes = [Int]()
+        var charsetnr = [UInt32]()
+        var scales = [Int]()
+        var decoders = [MySQLColumnDecoder]()
+        var nameBytes = [UInt8]()
+        var nameEnds = [Int]()
+        types.reserveCapacity(count)
+        sizes.reserveCapacity(count)
+        charsetnr.reserveCapacity(count)
+        scales.reserveCapacity(count)
+        decoders.reserveCapacity(count)
+        nameEnds.reserveCapacity(count)
+
+        for index in 0 ..< count {
+            let field = fields[index]
+            types.append(field.type)
+            sizes.append(MySQLResultFetcher.getSize(field: field))
+            charsetnr.append(field.charsetnr)
+            scales.append(Int(field.decimals))
+            decoders.append(MySQLColumnDecoder(type: field.type, charsetnr: field.charsetnr))
+            if let name = field.name {
+                let bytes = UnsafeRawPointer(name).assumingMemoryBound(to: UInt8.self)
+                nameBytes.append(contentsOf: UnsafeBufferPointer(start: bytes, count: Int(field.name_length)))
+            }
+            nameEnds.append(nameBytes.count)
+        }
+        mysql_free_result(result)
+
+        self.nameBytes = nameBytes
+        self.nameEnds = nameEnds
+        self.types = types
+        self.sizes = sizes
+        self.charsetnr = charsetnr
+        self.scales = scales
+        self.decoders = decoders
+    }
+
+    /// The number of columns.
+    var count: Int {
+        return types.count
+    }
+
+    /// The names of the columns, created on first use.
+    var titles: [String] {
+        lock.lock()
+        defer { lock.unlock() }
+        if let names = names {
+            return names
+        }
+        var names = [String]()
+        names.reserveCapacity(count)
+        var start = 0
+        for end in nameEnds {
+            names.append(String(decoding: nameBytes[start ..< end], as: UTF8.self))
+            start = end
+        }
+        self.names = names
+        return names
+    }
+}
@@ -0,0 +1,531 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+import Dispatch
+
+import SwiftKuery
+
+/// Options controlling how a `MySQLRoutingPool` routes queries between the primary and the replicas.
+public struct MySQLRoutingOptions {
+
+    /// The largest replication lag in seconds of a replica that reads are routed to, defaults to nil, no limit.
+    /// Reads go to the primary when every replica is lagging further behind.
+    public var maxReplicationLag: Int?
+
+    /// The interval at which the replication lag of the replicas is checked when `maxReplicationLag` is set, defaults to 5 seconds.
+    public var lagCheckInterval: TimeInterval
+
+    /// The time after a write during which the reads of the same connection are routed to the primary, so that they
+    /// see the data written. Defaults to 0, reads go to the replicas straight away. `.infinity` pins the reads of a
+    /// connection to the primary for the rest of its use once it has written.
+    public var readYourWritesWindow: TimeInterval
+
+    /// Initialize an instance of MySQLRoutingOptions.
+    ///
+    /// - Parameter maxReplicationLag: The largest replication lag in seconds of a replica that reads are routed to.
+    /// - Parameter lagCheckInterval: The interval at which the replication lag of the replicas is checked.
+    /// - Parameter readYourWritesWindow: The time after a write during which reads are routed to the primary.
+    public init(maxReplicationLag: Int? = nil, lagCheckInterval: TimeInterval = 5, readYourWritesWindow: TimeInterval = 0) {
+        self.maxReplicationLag = maxReplicationLag
+        self.lagCheckInterval = lagCheckInterval
+        self.readYourWritesWindow = readYourWritesWindow
+    }
+}
+
+/// A connection pool splitting reads and writes between a primary and its read replicas, each served by a
+/// `ConnectionPool` such as those created by `MySQLConnection.createPool`.
+///
+/// The connections handed out by the routing pool implement `Connection`, so application code is unchanged:
+/// `Select` queries outside of a transaction are executed on the replica with the fewest outstanding requests,
+/// while all other queries, prepared statements and transactions run on a primary connection held by the routing
+/// connection until it is closed.
+public final class MySQLRoutingPool {
+
+    private let primary: ConnectionPool
+    private let replicas: [Replica]
+    let options: MySQLRoutingOptions
+    private let lock = NSLock()
+    private var timer: DispatchSourceTimer?
+
+    /// Initialize an instance of MySQLRoutingPool.
+    ///
+    /// - Parameter primary: The pool of connections to the primary.
+    /// - Parameter replicas: The pools of connections to each replica.
+    /// - Parameter options: The routing options.
+    public init(primary: ConnectionPool, replicas: [ConnectionPool], options: MySQLRoutingOptions = MySQLRoutingOptions()) {
+        self.primary = primary
+        self.replicas = replicas.map { Replica(pool: $0) }
+        self.options = options
+
+        if let maxLag = options.maxReplicationLag, !replicas.isEmpty, options.lagCheckInterval > 0 {
+            let timer = DispatchSource.makeTimerSource(queue: DispatchQueue.global())
+            timer.schedule(deadline: .now(), repeating: options.lagCheckInterval)
+            timer.setEventHandler { [weak self] in
+                self?.checkReplicationLag(maxLag: maxLag)
+            }
+            timer.resume()
+            self.timer = timer
+        }
+    }
+
+    deinit {
+        timer?.cancel()
+    }
+
+    /// Get a routing connection. It takes connections from the underlying pools as they are needed,
+    /// and returns them when it is closed.
+    ///
+    /// - Parameter poolTask: The function to be called with the connection.
+    public func getConnection(poolTask: @escaping (Connection?, QueryError?) -> ()) {
+        poolTask(MySQLRoutingConnection(pool: self), nil)
+    }
+
+    func getPrimaryConnection(onCompletion: @escaping (Connection?, QueryError?) -> ()) {
+        primary.getConnection(poolTask: onCompletion)
+    }
+
+    /// Take the replica with the fewest outstanding requests that is not lagging, or nil if there is none.
+    func acquireReplica() -> Replica? {
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        var chosen: Replica? = nil
+        for replica in replicas where !replica.isLagging {
+            if chosen == nil || replica.outstanding < chosen!.outstanding {
+                chosen = replica
+            }
+        }
+        chosen?.outstanding += 1
+        return chosen
+    }
+
+    /// Record the completion of a request on a replica taken with `acquireReplica()`.
+    func releaseReplica(_ replica: Replica) {
+        lock.lock()
+        replica.outstanding -= 1
+        lock.unlock()
+    }
+
+    private func checkReplicationLag(maxLag: Int) {
+        for replica in replicas {
+            replica.pool.getConnection { connection, _ in
+                guard let connection = connection else {
+                    return self.setLagging(replica, true)
+                }
+                self.replicaStatus(of: replica, on: connection) { result in
+                    guard let resultSet = result.asResultSet else {
+                        connection.closeConnection()
+                        return self.setLagging(replica, result.asError != nil)
+                    }
+                    resultSet.getColumnTitles { titles, _ in
+                        resultSet.nextRow { row, _ in
+                            var lagging = false
+                            if let titles = titles, let row = row {
+                                for (index, title) in titles.enumerated() where title == "Seconds_Behind_Master" || title == "Seconds_Behind_Source" {
+                                    // NULL when replication is not running
+                                    let lag = row[index].flatMap { Int(String(describing: $0)) }
+                                    lagging = lag.map { $0 > maxLag } ?? true
+                                }
+                            }
+                            resultSet.done()
+                            connection.closeConnection()
+                            self.setLagging(replica, lagging)
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    /// Query the replication status of a replica with SHOW REPLICA STATUS, or with SHOW SLAVE STATUS on servers
+    /// older than MySQL 8.0.22, which do not have the new statement. MySQL 8.4 removed the old statement.
+    private func replicaStatus(of replica: Replica, on connection: Connection, onCompletion: @escaping (QueryResult) -> ()) {
+        lock.lock()
+        let legacy = replica.usesLegacyStatus
+        lock.unlock()
+        guard !legacy else {
+            return connection.execute("SHOW SLAVE STATUS", onCompletion: onCompletion)
+        }
+        connection.execute("SHOW REPLICA STATUS") { result in
+            guard result.asError != nil else {
+                return onCompletion(result)
+            }
+            connection.execute("SHOW SLAVE STATUS") { legacyResult in
+                if legacyResult.asError == nil {
+                    self.lock.lock()
+                    replica.usesLegacyStatus = true
+                    self.lock.unlock()
+                }
+                onCompletion(legacyResult)
+            }
+        }
+    }
+
+    private func setLagging(_ replica: Replica, _ lagging: Bool) {
+        lock.lock()
+        replica.isLagging = lagging
+        lock.unlock()
+    }
+
+    final class Replica {
+        let pool: ConnectionPool
+        var outstanding = 0
+        var isLagging = false
+        /// Whether the replica only supports SHOW SLAVE STATUS.
+        var usesLegacyStatus = false
+
+        init(pool: ConnectionPool) {
+            self.pool = pool
+        }
+    }
+}
+
+/// A connection of a `MySQLRoutingPool`, routing each operation to the primary or to a replica.
+class MySQLRoutingConnection: Connection {
+
+    private let pool: MySQLRoutingPool
+    private let lock = NSLock()
+    private var primary: Connection?
+    private var primaryWaiters = [(Connection?, QueryError?) -> ()]()
+    private var lastWrite: Date?
+    private var closed = false
+
+    /// The `QueryBuilder` with MySQL specific substitutions.
+    let queryBuilder: QueryBuilder = MySQLConnection.createQueryBuilder()
+
+    init(pool: MySQLRoutingPool) {
+        self.pool = pool
+    }
+
+    deinit {
+        primary?.closeConnection()
+    }
+
+    var isConnected: Bool {
+        lock.lock()
+        defer {
+            lock.unlock()
+        }
+        return !closed && (primary?.isConnected ?? true)
+    }
+
+    func connect(onCompletion: @escaping (QueryResult) -> ()) {
+        onCompletion(connectSync())
+    }
+
+    func connectSync() -> QueryResult {
+        lock.lock()
+        closed = false
+        lock.unlock()
+        return .successNoData
+    }
+
+    /// Return the primary connection to its pool.
+    func closeConnection() {
+        lock.lock()
+        let primary = self.primary
+        self.primary = nil
+        closed = true
+        lastWrite = nil
+        lock.unlock()
+        primary?.closeConnection()
+    }
+
+    func descriptionOf(query: Query) throws -> String {
+        return try query.build(queryBuilder: queryBuilder)
+    }
+
+    func execute(query: Query, onCompletion: @escaping ((QueryResult) -> ())) {
+        if query is Select {
+            return read(onCompletion: onCompletion) { connection, completion in
+                connection.execute(query: query, onCompletion: completion)
+            }
+        }
+        write(onCompletion: onCompletion) { connection, completion in
+            connection.execute(query: query, onCompletion: completion)
+        }
+    }
+
+    func execute(query: Query, parameters: [Any?], onCompletion: @escaping ((QueryResult) -> ())) {
+        if query is Select {
+            return read(onCompletion: onCompletion) { connection, completion in
+                connection.execute(query: query, parameters: parameters, onCompletion: completion)
+            }
+        }
+        write(onCompletion: onCompletion) { connection, completion in
+            connection.execute(query: query, parameters: parameters, onCompletion: completion)
+        }
+    }
+
+    func execute(query: Query, parameters: [String:Any?], onCompletion: @escaping ((QueryResult) -> ())) {
+        if query is Select {
+            return read(onCompletion: onCompletion) { connection, completion in
+                connection.execute(query: query, parameters: parameters, onCompletion: completion)
+            }
+        }
+        write(onCompletion: onCompletion) { connection, completion in
+            connection.execute(query: query, parameters: parameters, onCompletion: completion)
+        }
+    }
+
+    // Raw queries may write, so they always run on the primary
+
+    func execute(_ raw: String, onCompletion: @escaping ((QueryResult) -> ())) {
+        write(onCompletion: onCompletion) { connection, completion in
+            connection.execute(raw, onCompletion: completion)
+        }
+    }
+
+    func execute(_ raw: String, parameters: [Any?], onCompletion: @escaping ((QueryResult) -> ())) {
+        write(onCompletion: onCompletion) { connection, completion in
+            connection.execute(raw, parameters: parameters, onCompletion: completion)
+        }
+    }
+
+    func execute(_ raw: String, parameters: [String:Any?], onCompletion: @escaping ((QueryResult) -> ())) {
+        write(onCompletion: onCompletion) { connection, completion in
+            connection.execute(raw, parameters: parameters, onCompletion: completion)
+        }
+    }
+
+    // Prepared statements belong to a connection, so they are prepared and executed on the primary
+
+    func prepareStatement(_ query: Query, onCompletion: @escaping ((QueryResult) -> ())) {
+        onPrimary(onCompletion: onCompletion) { connection, completion in
+            connection.prepareStatement(query, onCompletion: completion)
+        }
+    }
+
+    func prepareStatement(_ raw: String, onCompletion: @escaping ((QueryResult) -> ())) {
+        onPrimary(onCompletion: onCompletion) { connection, completion in
+            connection.prepareStatement(raw, onCompletion: completion)
+        }
+    }
+
+    func release(preparedStatement: PreparedStatement, onCompletion: @escaping ((QueryResult) -> ())) {
+        onPrimary(onCompletion: onCompletion) { connection, completion in
+            connection.release(preparedStatement: preparedStatement, onCompletion: completion)
+        }
+    }
+
+    func execute(preparedStatement: PreparedStatement, onCompletion: @escaping ((QueryResult) -> ())) {
+        write(onCompletion: onCompletion) { connection, completion in
+            connection.execute(preparedStatement: preparedStatement, onCompletion: completion)
+        }
+    }
+
+    func execute(preparedStatement: PreparedStatement, parameters: [Any?], onCompletion: @escaping ((QueryResult) -> ())) {
+        write(onCompletion: onCompletion) { connection, completion in
+            connection.execute(preparedStatement: preparedStatement, parameters: parameters, onCompletion: completion)
+        }
+    }
+
+    func execute(preparedStatement: PreparedStatement, parameters: [String:Any?], onCompletion: @escaping ((QueryResult) -> ())) {
+        write(onCompletion: onCompletion) { connection, completion in
+            connection.execute(preparedStatement: preparedStatement, parameters: parameters, onCompletion: completion)
+        }
+    }
+
+    func startTransaction(onCompletion: @escaping ((QueryResult) -> ())) {
+        onPrimary(onCompletion: onCompletion) { connection, completion in
+            connection.startTransaction(onCompletion: completion)
+        }
+    }
+
+    func commit(onCompletion: @escaping ((QueryResult) -> ())) {
+        onPrimary(onCompletion: onCompletion) { connection, completion in
+            connection.commit(onCompletion: completion)
+        }
+    }
+
+    func rollback(onCompletion: @escaping ((QueryResult) -> ())) {
+        onPrimary(onCompletion: onCompletion) { connection, completion in
+            connection.rollback(onCompletion: completion)
+        }
+    }
+
+    func create(savepoint: String, onCompletion: @escaping ((QueryResult) -> ())) {
+        onPrimary(onCompletion: onCompletion) { connection, completion in
+            connection.create(savepoint: savepoint, onCompletion: completion)
+        }
+    }
+
+    func rollback(to savepoint: String, onCompletion: @escaping ((QueryResult) -> ())) {
+        onPrimary(onCompletion: onCompletion) { connection, completion in
+            connection.rollback(to: savepoint, onCompletion: completion)
+        }
+    }
+
+    func release(savepoint: String, onCompletion: @escaping ((QueryResult) -> ())) {
+        onPrimary(onCompletion: onCompletion) { connection, completion in
+            connection.release(savepoint: savepoint, onCompletion: completion)
+        }
+    }
+
+    /// Whether reads must run on the primary, in a transaction or shortly after a write.
+    private var readsFromPrimary: Bool {
+        lock.lock()
+        let primary = self.primary
+        let lastWrite = self.lastWrite
+        lock.unlock()
+        if let primary = primary {
+            // The transaction state is asked of the primary connection, which also sees the transactions of raw queries
+            // and those that ended with an error. Reads stay on a primary whose state cannot be known.
+            guard let connection = MySQLRoutingConnection.mysqlConnection(primary), !connection.isInTransaction else {
+                return true
+            }
+        }
+        guard let lastWrite = lastWrite else {
+            return false
+        }
+        return -lastWrite.timeIntervalSinceNow < pool.options.readYourWritesWindow
+    }
+
+    /// The `MySQLConnection` of a connection, which a `ConnectionPool` hands out wrapped in its own connection type.
+    static func mysqlConnection(_ connection: Connection) -> MySQLConnection? {
+        if let connection = connection as? MySQLConnection {
+            return connection
+        }
+        for child in Mirror(reflecting: connection).children where child.label == "connection" {
+            switch child.value {
+            case let connection as MySQLConnection:
+                return connection
+            case let connection as Connection?:
+                return connection.flatMap { mysqlConnection($0) }
+            default:
+                return nil
+            }
+        }
+        return nil
+    }
+
+    /// Run a read on the least loaded replica, holding the replica connection until its result set is done.
+    private func read(onCompletion: @escaping ((QueryResult) -> ()), operation: @escaping (Connection, @escaping (QueryResult) -> ()) -> ()) {
+        guard !readsFromPrimary, let replica = pool.acquireReplica() else {
+            return onPrimary(onCompletion: onCompletion, operation: operation)
+        }
+
+        replica.pool.getConnection { connection, _ in
+            guard let connection = connection else {
+                // Fall back to the primary when the replica is unavailable
+                self.pool.releaseReplica(replica)
+                return self.onPrimary(onCompletion: onCompletion, operation: operation)
+            }
+            let finish = {
+                connection.closeConnection()
+                self.pool.releaseReplica(replica)
+            }
+            operation(connection) { result in
+                guard let resultSet = result.asResultSet else {
+                    finish()
+                    return onCompletion(result)
+                }
+                let fetcher = MySQLForwardingResultFetcher(resultSet: resultSet, onDone: finish)
+                onCompletion(.resultSet(ResultSet(fetcher, connection: self)))
+            }
+        }
+    }
+
+    /// Run an operation that may write on the primary, recording the time of the write for `readYourWritesWindow`.
+    private func write(onCompletion: @escaping ((QueryResult) -> ()), operation: @escaping (Connection, @escaping (QueryResult) -> ()) -> ()) {
+        onPrimary(onCompletion: onCompletion) { connection, completion in
+            operation(connection) { result in
+                self.lock.lock()
+                self.lastWrite = Date()
+                self.lock.unlock()
+                completion(result)
+            }
+        }
+    }
+
+    /// Run an operation on the primary connection, taking one from the primary pool if it is not held yet.
+    private func onPrimary(onCompletion: @escaping ((QueryResult) -> ()), operation: @escaping (Connection, @escaping (QueryResult) -> ()) -> ()) {
+        withPrimary { connection, error in
+            guard let connection = connection else {
+                return onCompletion(.error(error ?? QueryError.connection("Unable to get a connection to the primary")))
+            }
+            operation(connection, onCompletion)
+        }
+    }
+
+    private func withPrimary(_ callback: @escaping (Connection?, QueryError?) -> ()) {
+        lock.lock()
+        if let primary = primary {
+            lock.unlock()
+            return callback(primary, nil)
+        }
+        primaryWaiters.append(callback)
+        let first = primaryWaiters.count == 1
+        closed = false
+        lock.unlock()
+        guard first else {
+            return
+        }
+
+        pool.getPrimaryConnection { connection, error in
+            self.lock.lock()
+            self.primary = connection
+            let waiters = self.primaryWaiters
+            self.primaryWaiters = []
+            self.lock.unlock()
+            for waiter in waiters {
+                waiter(connection, error)
+            }
+        }
+    }
+}
+
+/// A result fetcher reading the rows of a result set of another connection, and calling `onDone` once it is done.
+class MySQLForwardingResultFetcher: ResultFetcher {
+
+    private let resultSet: ResultSet
+    private var onDone: (() -> ())?
+
+    init(resultSet: ResultSet, onDone: @escaping () -> ()) {
+        self.resultSet = resultSet
+        self.onDone = onDone
+    }
+
+    deinit {
+        done()
+    }
+
+    func fetchNext(callback: @escaping (([Any?]?, Error?)) -> ()) {
+        resultSet.nextRow { row, error in
+            if row == nil {
+                self.done()
+            }
+            callback((row, error))
+        }
+    }
+
+    func fetchTitles(callback: @escaping (([String]?, Error?)) -> ()) {
+        resultSet.getColumnTitles { titles, error in
+            callback((titles, error))
+        }
+    }
+
+    func done() {
+        guard let onDone = onDone else {
+            return
+        }
+        self.onDone = nil
+        resultSet.done()
+        onDone()
+    }
+}
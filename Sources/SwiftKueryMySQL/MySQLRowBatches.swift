@@ -0,0 +1,209 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#if swift(>=5.5)
+#if canImport(_Concurrency)
+
+import Foundation
+
+/// The rows of a result as an `AsyncSequence` of batches, created by `MySQLResultFetcher.batches(ofSize:prefetch:)`.
+/// Up to `prefetch` batches are fetched ahead of the consumer, fetching stops while they are not consumed.
+/// Cancelling the task iterating the batches, or leaving the loop early, cancels the fetch of the remaining rows.
+/// The rows of a fetcher can only be iterated once.
+@available(macOS 10.15, iOS 13, tvOS 13, watchOS 6, *)
+public struct MySQLRowBatches: AsyncSequence {
+    public typealias Element = [[Any?]]
+
+    private let fetcher: MySQLResultFetcher
+    private let batchSize: Int
+    private let prefetch: Int
+
+    init(fetcher: MySQLResultFetcher, batchSize: Int, prefetch: Int) {
+        self.fetcher = fetcher
+        self.batchSize = max(batchSize, 1)
+        self.prefetch = max(prefetch, 1)
+    }
+
+    public func makeAsyncIterator() -> AsyncIterator {
+        return AsyncIterator(prefetcher: MySQLRowPrefetcher(fetcher: fetcher, batchSize: batchSize, capacity: prefetch))
+    }
+
+    /// The iterator of the batches of rows.
+    public struct AsyncIterator: AsyncIteratorProtocol {
+        private let prefetcher: MySQLRowPrefetcher
+
+        init(prefetcher: MySQLRowPrefetcher) {
+            self.prefetcher = prefetcher
+        }
+
+        /// Return the next batch of rows, or nil when there are no more rows.
+        ///
+        /// - Throws: The error fetching the rows, or CancellationError if the task was cancelled.
+        public mutating func next() async throws -> [[Any?]]? {
+            return try await prefetcher.next()
+        }
+    }
+}
+
+/// The buffer of the batches fetched ahead of the consumer of a `MySQLRowBatches`.
+@available(macOS 10.15, iOS 13, tvOS 13, watchOS 6, *)
+final class MySQLRowPrefetcher: @unchecked Sendable {
+    private let fetcher: MySQLResultFetcher
+    private let batchSize: Int
+    private let capacity: Int
+
+    private let lock = NSLock()
+    private var batches = [[[Any?]]]()
+    private var fetching = false
+    private var finished = false
+    private var cancelled = false
+    private var error: Error? = nil
+    private var waiter: CheckedContinuation<[[Any?]]?, Error>? = nil
+
+    init(fetcher: MySQLResultFetcher, batchSize: Int, capacity: Int) {
+        self.fetcher = fetcher
+        self.batchSize = batchSize
+        self.capacity = capacity
+        lock.lock()
+        demand()
+        lock.unlock()
+    }
+
+    deinit {
+        // The consumer stopped iterating before the end of the rows
+        if !finished && !cancelled {
+            fetcher.cancel()
+        }
+    }
+
+    func next() async throws -> [[Any?]]? {
+        #if swift(>=5.7)
+        return try await withTaskCancellationHandler(operation: { try await self.take() }, onCancel: { self.cancel() })
+        #else
+        return try await withTaskCancellationHandler(handler: { self.cancel() }, operation: { try await self.take() })
+        #endif
+    }
+
+    private func take() async throws -> [[Any?]]? {
+        return try await withCheckedThrowingContinuation { continuation in
+            lock.lock()
+            if cancelled {
+                lock.unlock()
+                return continuation.resume(throwing: CancellationError())
+            }
+            if !batches.isEmpty {
+                let batch = batches.removeFirst()
+                demand()
+                lock.unlock()
+                return continuation.resume(returning: batch)
+            }
+            if finished {
+                let error = self.error
+                self.error = nil
+                lock.unlock()
+                if let error = error {
+                    return continuation.resume(throwing: error)
+                }
+                return continuation.resume(returning: nil)
+            }
+            waiter = continuation
+            demand()
+            lock.unlock()
+        }
+    }
+
+    private func cancel() {
+        lock.lock()
+        guard !cancelled && !finished else {
+            lock.unlock()
+            return
+        }
+        cancelled = true
+        batches = []
+        let waiter = self.waiter
+        self.waiter = nil
+        lock.unlock()
+
+        fetcher.cancel()
+        waiter?.resume(throwing: CancellationError())
+    }
+
+    /// Request the next batch unless one is being fetched or the buffer is full. Called with the lock held.
+    private func demand() {
+        guard !fetching && !finished && !cancelled && batches.count < capacity else {
+            return
+        }
+        fetching = true
+        fetcher.fetchNext(batchSize: batchSize) { [weak self] result in
+            self?.received(result.0, result.1)
+        }
+    }
+
+    private func received(_ batch: [[Any?]]?, _ error: Error?) {
+        lock.lock()
+        fetching = false
+        guard !cancelled else {
+            lock.unlock()
+            return
+        }
+        if let batch = batch, error == nil {
+            if let waiter = waiter {
+                self.waiter = nil
+                demand()
+                lock.unlock()
+                return waiter.resume(returning: batch)
+            }
+            batches.append(batch)
+            demand()
+            lock.unlock()
+            return
+        }
+
+        finished = true
+        if error != nil {
+            fetcher.done()
+        }
+        guard let waiter = waiter else {
+            self.error = error
+            lock.unlock()
+            return
+        }
+        self.waiter = nil
+        lock.unlock()
+        if let error = error {
+            return waiter.resume(throwing: error)
+        }
+        waiter.resume(returning: nil)
+    }
+}
+
+@available(macOS 10.15, iOS 13, tvOS 13, watchOS 6, *)
+extension MySQLResultFetcher {
+
+    /// The rows of the result as an `AsyncSequence` of batches of rows. Up to `prefetch` batches are fetched ahead
+    /// of the consumer, no more rows are read from the server while they are not consumed.
+    /// Cancelling the iterating task, or leaving the loop early, cancels the fetch of the remaining rows, see `cancel()`.
+    ///
+    /// - Parameter batchSize: The maximum number of rows of each batch.
+    /// - Parameter prefetch: The maximum number of batches fetched ahead of the consumer.
+    /// - Returns: The batches of rows of the result.
+    public func batches(ofSize batchSize: Int = 256, prefetch: Int = 2) -> MySQLRowBatches {
+        return MySQLRowBatches(fetcher: self, batchSize: batchSize, prefetch: prefetch)
+    }
+}
+
+#endif
+#endif
@@ -0,0 +1,180 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+
+import CMySQL
+
+/// A least recently used cache of the prepared statements of a single connection, keyed by their SQL text.
+///
+/// A statement is taken out of the cache while it is in use and is put back when it is released, after its result
+/// is freed. It is only reset with `mysql_stmt_reset`, a round trip to the server, when its result was not read
+/// to the end. All cached statements are closed when the connection is closed or when the client has reconnected
+/// to the server, as the server discards prepared statements together with the session.
+class MySQLStatementCache {
+
+    private struct Entry {
+        let statement: MySQLPreparedStatement
+        let lastUsed: UInt64
+    }
+
+    private var entries = [String: Entry]()
+    private var clock: UInt64 = 0
+    private var connectionID: UInt = 0
+    private var hitCount = 0
+    private var missCount = 0
+    private let lock = NSLock()
+
+    private var _capacity: Int
+
+    /// The maximum number of statements kept in the cache, 0 disables caching.
+    var capacity: Int {
+        get {
+            lock.lock()
+            defer { lock.unlock() }
+            return _capacity
+        }
+        set {
+            lock.lock()
+            defer { lock.unlock() }
+            _capacity = max(newValue, 0)
+            while entries.count > _capacity {
+                evictLeastRecentlyUsed()
+            }
+        }
+    }
+
+    /// The number of times a statement was found in the cache.
+    var hits: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return hitCount
+    }
+
+    /// The number of times a statement had to be prepared while the cache was enabled.
+    var misses: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return missCount
+    }
+
+    init(capacity: Int) {
+        self._capacity = max(capacity, 0)
+    }
+
+    /// Take the statement prepared for `key` out of the cache.
+    ///
+    /// - Parameter key: The SQL text of the statement.
+    /// - Parameter connectionID: The thread ID of the current server session, as returned by `mysql_thread_id`.
+    /// - Returns: The cached statement or nil if there is none.
+    func checkOut(_ key: String, connectionID: UInt) -> MySQLPreparedStatement? {
+        lock.lock()
+        defer { lock.unlock() }
+
+        guard _capacity > 0 else {
+            return nil
+        }
+
+        if connectionID != self.connectionID {
+            // The session has changed, the statements prepared in the previous one no longer exist on the server.
+            closeAll()
+            self.connectionID = connectionID
+        }
+
+        guard let entry = entries.removeValue(forKey: key) else {
+            missCount += 1
+            return nil
+        }
+        hitCount += 1
+        return entry.statement
+    }
+
+    /// Mark a newly prepared statement as belonging to the cache, so that it is returned to it on release.
+    ///
+    /// - Parameter statement: The prepared statement.
+    /// - Parameter key: The SQL text of the statement.
+    /// - Parameter connectionID: The thread ID of the server session the statement was prepared in.
+    func adopt(_ statement: MySQLPreparedStatement, key: String, connectionID: UInt) {
+        guard capacity > 0 else {
+            return
+        }
+        statement.cache = self
+        statement.cacheKey = key
+        statement.connectionID = connectionID
+    }
+
+    /// Free the result of a released statement, reset it if needed, and put it back in the cache.
+    ///
+    /// - Parameter statement: The prepared statement being released.
+    /// - Returns: false if the cache did not keep the statement, in which case it should be closed by the caller.
+    func checkIn(_ statement: MySQLPreparedStatement) -> Bool {
+        guard let key = statement.cacheKey, let statementPtr = statement.statement else {
+            return false
+        }
+
+        lock.lock()
+        let keep = _capacity > 0 && statement.connectionID == connectionID && entries[key] == nil
+        lock.unlock()
+
+        guard keep else {
+            return false
+        }
+
+        mysql_stmt_free_result(statementPtr)
+        // No long data is ever sent, so a statement whose result was read to the end is ready for its next execution
+        if statement.hasUnreadResult {
+            statement.hasUnreadResult = false
+            guard mysql_stmt_reset(statementPtr) == mysql_false() else {
+                return false
+            }
+        }
+
+        lock.lock()
+        defer { lock.unlock() }
+
+        guard _capacity > 0, statement.connectionID == connectionID, entries[key] == nil else {
+            return false
+        }
+        if entries.count >= _capacity {
+            evictLeastRecentlyUsed()
+        }
+        clock += 1
+        entries[key] = Entry(statement: statement, lastUsed: clock)
+        return true
+    }
+
+    /// Close all the statements in the cache.
+    func removeAll() {
+        lock.lock()
+        defer { lock.unlock() }
+        closeAll()
+    }
+
+    private func closeAll() {
+        for entry in entries.values {
+            entry.statement.close()
+        }
+        entries.removeAll()
+    }
+
+    private func evictLeastRecentlyUsed() {
+        guard let oldest = entries.min(by: { $0.value.lastUsed < $1.value.lastUsed }) else {
+            return
+        }
+        entries.removeValue(forKey: oldest.key)
+        oldest.value.statement.close()
+    }
+}
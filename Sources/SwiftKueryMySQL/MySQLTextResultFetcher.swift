@@ -0,0 +1,238 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import SwiftKuery
+import Foundation
+
+import CMySQL
+
+/// A query result fetcher for results of the text protocol that have been stored on the client,
+/// as returned by queries executed with a `MySQLEventLoop`. The values are decoded to the same
+/// types as the values of `MySQLResultFetcher`.
+public class MySQLTextResultFetcher: ResultFetcher {
+
+    private var result: UnsafeMutablePointer<MYSQL_RES>?
+    private var types = [enum_field_types]()
+    private var charsetnr = [UInt32]()
+    private var scales = [Int]()
+    private var fieldNames = [String]()
+
+    private let timeConverter: MySQLTimeConverter
+    private let dateAndTimeAsValueTypes: Bool
+    private let decimalDecoding: MySQLDecimalDecoding
+
+    /// The number of rows in the result set.
+    public let rowCount: Int
+
+    init(result: UnsafeMutablePointer<MYSQL_RES>, typeOptions: MySQLTypeOptions) {
+        self.result = result
+        self.timeConverter = MySQLTimeConverter(timeZone: typeOptions.timeZone)
+        self.dateAndTimeAsValueTypes = typeOptions.dateAndTimeAsValueTypes
+        self.decimalDecoding = typeOptions.decimals
+        self.rowCount = Int(mysql_num_rows(result))
+
+        if let fields = mysql_fetch_fields(result) {
+            for i in 0 ..< Int(mysql_num_fields(result)) {
+                types.append(fields[i].type)
+                charsetnr.append(fields[i].charsetnr)
+                scales.append(Int(fields[i].decimals))
+                fieldNames.append(String(cString: fields[i].name))
+            }
+        }
+    }
+
+    deinit {
+        done()
+    }
+
+    /// Indicate no further calls will be made to this ResultFetcher, freeing the stored result.
+    public func done() {
+        if let result = result {
+            self.result = nil
+            mysql_free_result(result)
+        }
+    }
+
+    /// Fetch the next row of the query result. As the result is stored on the client, this does not wait for the server.
+    ///
+    /// - Parameter callback: A callback to call when the next row of the query result is ready.
+    public func fetchNext(callback: @escaping (([Any?]?, Error?)) -> ()) {
+        guard let result = result, let row = mysql_fetch_row(result), let lengths = mysql_fetch_lengths(result) else {
+            done()
+            return callback((nil, nil))
+        }
+
+        var values = [Any?]()
+        values.reserveCapacity(types.count)
+        for index in 0 ..< types.count {
+            guard let value = row[index] else {
+                values.append(nil)
+                continue
+            }
+            values.append(decode(value, length: Int(lengths[index]), column: index))
+        }
+        callback((values, nil))
+    }
+
+    /// Fetch the titles of the query result.
+    ///
+    /// - Parameter callback: A closure that accepts a tuple containing an optional array of column titles of type String and an optional Error
+    public func fetchTitles(callback: @escaping (([String]?, Error?)) -> ()) {
+        return callback((fieldNames, nil))
+    }
+
+    private func decode(_ value: UnsafeMutablePointer<Int8>, length: Int, column: Int) -> Any? {
+        let bytes = UnsafeBufferPointer(start: UnsafeRawPointer(value).assumingMemoryBound(to: UInt8.self), count: length)
+        switch types[column] {
+        case MYSQL_TYPE_TINY:
+            return MySQLTextResultFetcher.integer(bytes).map { Int8(truncatingIfNeeded: $0) }
+        case MYSQL_TYPE_SHORT:
+            return MySQLTextResultFetcher.integer(bytes).map { Int16(truncatingIfNeeded: $0) }
+        case MYSQL_TYPE_INT24,
+             MYSQL_TYPE_LONG:
+            return MySQLTextResultFetcher.integer(bytes).map { Int32(truncatingIfNeeded: $0) }
+        case MYSQL_TYPE_LONGLONG:
+            return MySQLTextResultFetcher.integer(bytes)
+        case MYSQL_TYPE_FLOAT:
+            return Float(string(bytes))
+        case MYSQL_TYPE_DOUBLE:
+            return Double(string(bytes))
+        case MYSQL_TYPE_NEWDECIMAL:
+            return MySQLDecimalConverter.decode(bytes, as: decimalDecoding, scale: scales[column])
+        case MYSQL_TYPE_TINY_BLOB,
+             MYSQL_TYPE_BLOB,
+             MYSQL_TYPE_MEDIUM_BLOB,
+             MYSQL_TYPE_LONG_BLOB:
+            if charsetnr[column] == 63 {
+                // Value 63 is used to denote binary data
+                return Data(bytes)
+            }
+            return string(bytes)
+        case MYSQL_TYPE_BIT:
+            return Data(bytes)
+        case MYSQL_TYPE_TIME:
+            guard dateAndTimeAsValueTypes, let time = MySQLTextResultFetcher.time(bytes, isTime: true) else {
+                return string(bytes)
+            }
+            return MySQLTime(time)
+        case MYSQL_TYPE_DATE:
+            guard dateAndTimeAsValueTypes, let time = MySQLTextResultFetcher.time(bytes, isTime: false) else {
+                return string(bytes)
+            }
+            return MySQLDate(time)
+        case MYSQL_TYPE_DATETIME,
+             MYSQL_TYPE_TIMESTAMP:
+            return MySQLTextResultFetcher.time(bytes, isTime: false).flatMap { timeConverter.date(from: $0) }
+        default:
+            return string(bytes)
+        }
+    }
+
+    private func string(_ bytes: UnsafeBufferPointer<UInt8>) -> String {
+        return String(decoding: bytes, as: UTF8.self)
+    }
+
+    /// Parse a decimal integer without creating a String.
+    static func integer(_ bytes: UnsafeBufferPointer<UInt8>) -> Int64? {
+        var index = 0
+        let negative = bytes.first == UInt8(ascii: "-")
+        if negative {
+            index = 1
+        }
+        guard index < bytes.count else {
+            return nil
+        }
+
+        var value: Int64 = 0
+        while index < bytes.count {
+            let digit = Int64(bytes[index]) - Int64(UInt8(ascii: "0"))
+            guard digit >= 0 && digit <= 9 else {
+                return nil
+            }
+            // Accumulate negatively so that Int64.min can be parsed
+            value = value &* 10 &- digit
+            index += 1
+        }
+        return negative ? value : 0 &- value
+    }
+
+    /// Parse the text of a DATE, DATETIME, TIMESTAMP or TIME value into a MYSQL_TIME.
+    static func time(_ bytes: UnsafeBufferPointer<UInt8>, isTime: Bool) -> MYSQL_TIME? {
+        var time = MYSQL_TIME()
+        var index = 0
+
+        func number(maxDigits: Int = Int.max) -> UInt32? {
+            var value: UInt32 = 0
+            var digits = 0
+            while index < bytes.count, digits < maxDigits, bytes[index] >= UInt8(ascii: "0"), bytes[index] <= UInt8(ascii: "9") {
+                value = value &* 10 &+ UInt32(bytes[index] - UInt8(ascii: "0"))
+                index += 1
+                digits += 1
+            }
+            return digits > 0 ? value : nil
+        }
+
+        func skip(_ separator: Unicode.Scalar) -> Bool {
+            guard index < bytes.count, bytes[index] == UInt8(ascii: separator) else {
+                return false
+            }
+            index += 1
+            return true
+        }
+
+        if isTime {
+            if skip("-") {
+                time.neg = mysql_true()
+            }
+            guard let hour = number(), skip(":"), let minute = number(), skip(":"), let second = number() else {
+                return nil
+            }
+            time.hour = hour
+            time.minute = minute
+            time.second = second
+            time.time_type = MYSQL_TIMESTAMP_TIME
+        } else {
+            guard let year = number(), skip("-"), let month = number(), skip("-"), let day = number() else {
+                return nil
+            }
+            time.year = year
+            time.month = month
+            time.day = day
+            time.time_type = MYSQL_TIMESTAMP_DATE
+            if skip(" ") {
+                guard let hour = number(), skip(":"), let minute = number(), skip(":"), let second = number() else {
+                    return nil
+                }
+                time.hour = hour
+                time.minute = minute
+                time.second = second
+                time.time_type = MYSQL_TIMESTAMP_DATETIME
+            }
+        }
+
+        if skip(".") {
+            let start = index
+            if let fraction = number(maxDigits: 6) {
+                var microseconds = UInt(fraction)
+                for _ in (index - start) ..< 6 {
+                    microseconds *= 10
+                }
+                time.second_part = microseconds
+            }
+        }
+        return time
+    }
+}
@@ -0,0 +1,49 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+#if os(Linux)
+import Glibc
+#else
+import Darwin
+#endif
+
+import CMySQL
+
+/// Per thread initialization of the MySQL client library.
+///
+/// `mysql_thread_init` is called the first time a thread makes MySQL calls, and `mysql_thread_end`
+/// when the thread exits, rather than around every operation.
+enum MySQLThread {
+
+    private static let key: pthread_key_t = {
+        var key = pthread_key_t()
+        let status = pthread_key_create(&key) { _ in
+            mysql_thread_end()
+        }
+        precondition(status == 0, "Unable to create the thread specific key for MySQL thread initialization")
+        return key
+    }()
+
+    /// Initialize the MySQL client library for the calling thread, if it has not been already.
+    static func initialize() {
+        guard pthread_getspecific(key) == nil else {
+            return
+        }
+        mysql_thread_init()
+        // Any non nil value marks the thread as initialized and makes the destructor run when it exits
+        pthread_setspecific(key, UnsafeRawPointer(bitPattern: 1))
+    }
+}
@@ -0,0 +1,113 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+
+import SwiftKuery
+
+/// How `MySQLConnection` starts and ends transactions.
+public enum MySQLTransactionMode {
+    /// START TRANSACTION, COMMIT and ROLLBACK are sent to the server when they are called, the default.
+    case immediate
+
+    /// `startTransaction` sends nothing to the server: START TRANSACTION is sent in the same operation as the first
+    /// statement of the transaction, and in the same round trip when that is a pipeline, see `MySQLConnection.execute(pipeline:onCompletion:)`.
+    /// The transaction is ended with `mysql_commit` or `mysql_rollback`, and a transaction in which no statement
+    /// was executed ends without contacting the server.
+    case deferred
+}
+
+/// The result of a statement executed in a `MySQLTransaction`, with all the rows of its result set.
+public struct MySQLStatementResult {
+    /// The number of rows changed by an insert, update or delete.
+    public let affectedRows: UInt64
+
+    /// The auto increment ID generated by an insert, or 0.
+    public let insertID: UInt64
+
+    /// The column titles of the result set, empty if the statement did not return one.
+    public let titles: [String]
+
+    /// The rows of the result set, empty if the statement did not return one.
+    public let rows: [[Any?]]
+
+    init(affectedRows: UInt64 = 0, insertID: UInt64 = 0, titles: [String] = [], rows: [[Any?]] = []) {
+        self.affectedRows = affectedRows
+        self.insertID = insertID
+        self.titles = titles
+        self.rows = rows
+    }
+}
+
+/// The statements of a transaction run with `MySQLConnection.withTransaction(_:onCompletion:)`.
+///
+/// The statements are executed synchronously, one after the other on the queue of the connection, without an
+/// asynchronous hop between them, and all the rows of their results are read before they return. Only the statements
+/// executed through the transaction are part of it: a statement executed with the asynchronous functions of the
+/// connection from the body of the transaction runs after the transaction has ended. The transaction must not be
+/// used once its body has returned.
+public final class MySQLTransaction {
+
+    private var connection: MySQLConnection?
+
+    init(connection: MySQLConnection) {
+        self.connection = connection
+    }
+
+    /// Execute a raw query in the transaction.
+    ///
+    /// - Parameter raw: A String with the raw query to execute.
+    /// - Parameter parameters: An array of the parameters.
+    /// - Returns: The result of the query.
+    /// - Throws: QueryError if the query failed.
+    @discardableResult
+    public func execute(_ raw: String, parameters: [Any?] = []) throws -> MySQLStatementResult {
+        return try openConnection().executeOnCurrentThread(raw, query: nil, parameters: parameters)
+    }
+
+    /// Execute a query in the transaction.
+    ///
+    /// - Parameter query: The query to execute.
+    /// - Parameter parameters: An array of the parameters.
+    /// - Returns: The result of the query.
+    /// - Throws: QueryError if the query failed.
+    @discardableResult
+    public func execute(query: Query, parameters: [Any?] = []) throws -> MySQLStatementResult {
+        let connection = try openConnection()
+        let raw: String
+        do {
+            raw = try query.build(queryBuilder: connection.queryBuilder)
+        } catch let error {
+            throw QueryError.syntaxError("Unable to build query: \(error.localizedDescription)")
+        }
+        defer {
+            connection.didExecuteInTransaction(query)
+        }
+        return try connection.executeOnCurrentThread(raw, query: query, parameters: parameters)
+    }
+
+    /// End the use of the transaction, when its body has returned.
+    func end() {
+        connection = nil
+    }
+
+    private func openConnection() throws -> MySQLConnection {
+        guard let connection = connection else {
+            throw QueryError.transactionError("The transaction has ended")
+        }
+        return connection
+    }
+}
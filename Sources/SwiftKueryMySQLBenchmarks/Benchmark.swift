@@ -0,0 +1,134 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+import Dispatch
+
+/// An error stopping the benchmarks.
+struct BenchmarkError: Error, CustomStringConvertible {
+    let description: String
+
+    init(_ description: String) {
+        self.description = description
+    }
+}
+
+/// The timings of the iterations of a benchmark, each processing `items` operations or rows.
+struct BenchmarkResult {
+    let name: String
+    let items: Int
+    let samples: [Double]
+
+    var median: Double {
+        return percentile(0.5)
+    }
+
+    var p90: Double {
+        return percentile(0.9)
+    }
+
+    var min: Double {
+        return samples.min() ?? 0
+    }
+
+    /// The number of items processed per second by the median iteration.
+    var itemsPerSecond: Double {
+        return median > 0 ? Double(items) / median : 0
+    }
+
+    private func percentile(_ fraction: Double) -> Double {
+        guard !samples.isEmpty else {
+            return 0
+        }
+        let sorted = samples.sorted()
+        return sorted[Int((Double(sorted.count - 1) * fraction).rounded())]
+    }
+}
+
+/// Run `body` `warmUp` times, then `iterations` times measuring each run. `setUp` runs before every run, untimed.
+func measure(_ name: String, items: Int, iterations: Int, warmUp: Int = 2, setUp: (() throws -> ())? = nil, _ body: () throws -> ()) throws -> BenchmarkResult {
+    var samples = [Double]()
+    samples.reserveCapacity(iterations)
+    for iteration in 0 ..< warmUp + iterations {
+        try setUp?()
+        let start = DispatchTime.now().uptimeNanoseconds
+        try body()
+        let elapsed = DispatchTime.now().uptimeNanoseconds - start
+        if iteration >= warmUp {
+            samples.append(Double(elapsed) / 1_000_000_000)
+        }
+    }
+    return BenchmarkResult(name: name, items: items, samples: samples)
+}
+
+/// Serialize results as JSON with one benchmark per line and a fixed key order, so that result files can be diffed.
+func json(environment: [(String, String)], iterations: Int, results: [BenchmarkResult]) -> String {
+    var lines = [String]()
+    lines.append("{")
+    let fields = environment.map { "\(quoted($0.0)): \(quoted($0.1))" } + ["\"iterations\": \(iterations)"]
+    lines.append("  \"environment\": {" + fields.joined(separator: ", ") + "},")
+    lines.append("  \"benchmarks\": [")
+    for (index, result) in results.enumerated() {
+        let line = "    {\"name\": \(quoted(result.name)), \"items\": \(result.items), "
+            + "\"median_seconds\": \(number(result.median)), \"p90_seconds\": \(number(result.p90)), "
+            + "\"min_seconds\": \(number(result.min)), \"items_per_second\": \(number(result.itemsPerSecond))}"
+        lines.append(line + (index < results.count - 1 ? "," : ""))
+    }
+    lines.append("  ]")
+    lines.append("}")
+    return lines.joined(separator: "\n") + "\n"
+}
+
+/// Read the median of each benchmark from a file written by `json(environment:iterations:results:)`.
+func medians(fromFile path: String) throws -> [String: Double] {
+    let data = try Data(contentsOf: URL(fileURLWithPath: path))
+    guard let object = try JSONSerialization.jsonObject(with: data) as? [String: Any],
+        let benchmarks = object["benchmarks"] as? [[String: Any]] else {
+        throw BenchmarkError("Invalid benchmark results in \(path)")
+    }
+    var medians = [String: Double]()
+    for benchmark in benchmarks {
+        if let name = benchmark["name"] as? String, let median = benchmark["median_seconds"] as? Double {
+            medians[name] = median
+        }
+    }
+    return medians
+}
+
+private func number(_ value: Double) -> String {
+    return String(format: "%.9f", value)
+}
+
+private func quoted(_ string: String) -> String {
+    var escaped = "\""
+    for scalar in string.unicodeScalars {
+        switch scalar {
+        case "\"":
+            escaped += "\\\""
+        case "\\":
+            escaped += "\\\\"
+        case "\n":
+            escaped += "\\n"
+        default:
+            if scalar.value < 0x20 {
+                escaped += String(format: "\\u%04x", scalar.value)
+            } else {
+                escaped.unicodeScalars.append(scalar)
+            }
+        }
+    }
+    return escaped + "\""
+}
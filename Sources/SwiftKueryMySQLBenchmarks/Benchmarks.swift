@@ -0,0 +1,156 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+import Dispatch
+import SwiftKuery
+import SwiftKueryMySQL
+
+/// A benchmark of the suite, run against the connection to the fixtures.
+struct Benchmark {
+    let name: String
+    let run: (MySQLConnection, BenchmarkOptions) throws -> BenchmarkResult
+}
+
+/// The benchmarks of the hot paths of the driver, in the order they are run and reported.
+let benchmarks: [Benchmark] = [
+    Benchmark(name: "prepare_execute") { connection, options in
+        // A statement prepared, executed and released for every execution
+        return try measure("prepare_execute", items: 100, iterations: options.iterations) {
+            for value in 0 ..< 100 {
+                let prepared = synchronously { connection.prepareStatement("SELECT ?", onCompletion: $0) }
+                guard let statement = try check(prepared, "Prepare").asPreparedStatement else {
+                    throw BenchmarkError("Prepare returned no statement")
+                }
+                try drain(check(synchronously { connection.execute(preparedStatement: statement, parameters: [value], onCompletion: $0) }, "Execute"))
+                _ = synchronously { connection.release(preparedStatement: statement, onCompletion: $0) }
+            }
+        }
+    },
+    Benchmark(name: "execute_cached_statement") { connection, options in
+        let cacheSize = connection.statementCacheSize
+        connection.statementCacheSize = 16
+        defer {
+            connection.statementCacheSize = cacheSize
+        }
+        return try measure("execute_cached_statement", items: 100, iterations: options.iterations) {
+            for value in 0 ..< 100 {
+                try drain(check(synchronously { connection.execute("SELECT ?", parameters: [value], onCompletion: $0) }, "Execute"))
+            }
+        }
+    },
+    Benchmark(name: "fetch_narrow") { connection, options in
+        return try measure("fetch_narrow", items: FixtureSize.narrowRows, iterations: options.iterations) {
+            try drain(check(synchronously { connection.execute("SELECT id, value FROM benchNarrow WHERE id >= ?", parameters: [0], onCompletion: $0) }, "Select"))
+        }
+    },
+    Benchmark(name: "fetch_wide") { connection, options in
+        return try measure("fetch_wide", items: FixtureSize.wideRows, iterations: options.iterations) {
+            try drain(check(synchronously { connection.execute("SELECT * FROM benchWide WHERE c0 IS NOT NULL OR ? = 0", parameters: [0], onCompletion: $0) }, "Select"))
+        }
+    },
+    Benchmark(name: "decode_datetime") { connection, options in
+        return try measure("decode_datetime", items: FixtureSize.typesRows, iterations: options.iterations) {
+            try drain(check(synchronously { connection.execute("SELECT created FROM benchTypes WHERE id >= ?", parameters: [0], onCompletion: $0) }, "Select"))
+        }
+    },
+    Benchmark(name: "decode_blob") { connection, options in
+        return try measure("decode_blob", items: FixtureSize.typesRows, iterations: options.iterations) {
+            try drain(check(synchronously { connection.execute("SELECT payload FROM benchTypes WHERE id >= ?", parameters: [0], onCompletion: $0) }, "Select"))
+        }
+    },
+    Benchmark(name: "bind_parameters") { connection, options in
+        // 32 parameters of mixed types bound for each of 100 executions of a statement returning no rows,
+        // so that the time is spent binding rather than fetching
+        let parameters: [Any?] = (0 ..< 32).map { index -> Any? in
+            switch index % 6 {
+            case 0:
+                return index
+            case 1:
+                return Double(index) * 1.5
+            case 2:
+                return String(repeating: "s", count: 256)
+            case 3:
+                return fixtureBlob(index, size: 4096)
+            case 4:
+                return fixtureDate(index)
+            default:
+                return nil
+            }
+        }
+        let placeholders = [String](repeating: "?", count: parameters.count).joined(separator: ", ")
+        let prepared = synchronously { connection.prepareStatement("DO " + placeholders, onCompletion: $0) }
+        guard let statement = try check(prepared, "Prepare").asPreparedStatement else {
+            throw BenchmarkError("Prepare returned no statement")
+        }
+        defer {
+            _ = synchronously { connection.release(preparedStatement: statement, onCompletion: $0) }
+        }
+        let parameterSets = [[Any?]](repeating: parameters, count: 100)
+        return try measure("bind_parameters", items: parameterSets.count, iterations: options.iterations) {
+            try check(synchronously { connection.execute(preparedStatement: statement, parameterSets: parameterSets, onCompletion: $0) }, "Execute")
+        }
+    },
+    Benchmark(name: "pool_checkout") { _, options in
+        // 16 workers contending for the 4 connections of a pool
+        let workers = 16
+        let checkouts = 100
+        let pool = MySQLConnection.createPool(host: options.host, user: options.user, password: options.password, database: options.database, port: options.port,
+                                              poolOptions: ConnectionPoolOptions(initialCapacity: 4, maxCapacity: 4))
+        defer {
+            pool.disconnect()
+        }
+        let queue = DispatchQueue(label: "SwiftKueryMySQLBenchmarks.workers", attributes: .concurrent)
+        var failures = 0
+        let lock = NSLock()
+        let result = try measure("pool_checkout", items: workers * checkouts, iterations: options.iterations) {
+            let group = DispatchGroup()
+            for _ in 0 ..< workers {
+                queue.async(group: group) {
+                    for _ in 0 ..< checkouts {
+                        let connection: Connection? = synchronously { done in
+                            pool.getConnection { connection, _ in done(connection) }
+                        }
+                        guard let checkedOut = connection else {
+                            lock.lock()
+                            failures += 1
+                            lock.unlock()
+                            continue
+                        }
+                        checkedOut.closeConnection()
+                    }
+                }
+            }
+            group.wait()
+        }
+        if failures > 0 {
+            throw BenchmarkError("\(failures) pool checkouts failed")
+        }
+        return result
+    },
+    Benchmark(name: "batch_insert") { connection, options in
+        let table = BatchTable()
+        let insert = Insert(into: table, valueTuples: [(table.id, Parameter()), (table.name, Parameter()), (table.value, Parameter())])
+        let parameterSets: [[Any?]] = (0 ..< FixtureSize.batchRows).map { row in
+            [Int32(row), "name\(row)", Double(row) * 0.5]
+        }
+        return try measure("batch_insert", items: parameterSets.count, iterations: options.iterations, setUp: {
+            try run("TRUNCATE TABLE benchBatch", on: connection)
+        }) {
+            try check(synchronously { connection.execute(insert: insert, parameterSets: parameterSets, onCompletion: $0) }, "Insert")
+        }
+    },
+]
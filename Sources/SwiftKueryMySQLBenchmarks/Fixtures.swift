@@ -0,0 +1,166 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+import Dispatch
+import SwiftKuery
+import SwiftKueryMySQL
+
+/// The number of rows of each fixture table. The values of the rows are derived from their index,
+/// so that every run reads and writes the same data.
+enum FixtureSize {
+    static let narrowRows = 10_000
+    static let wideRows = 2_000
+    static let wideColumns = 40
+    static let typesRows = 10_000
+    static let blobSize = 1024
+    static let batchRows = 1_000
+}
+
+/// The table written by the batched insert benchmark.
+final class BatchTable: Table {
+    let id = Column("id")
+    let name = Column("name")
+    let value = Column("value")
+
+    let tableName = "benchBatch"
+}
+
+/// Wait for the completion of an asynchronous call.
+func synchronously<T>(_ body: (@escaping (T) -> ()) -> ()) -> T {
+    let semaphore = DispatchSemaphore(value: 0)
+    var value: T?
+    body { result in
+        value = result
+        semaphore.signal()
+    }
+    semaphore.wait()
+    return value!
+}
+
+/// Throw the error of a result, or return the result.
+@discardableResult
+func check(_ result: QueryResult, _ operation: String) throws -> QueryResult {
+    if let error = result.asError {
+        throw BenchmarkError("\(operation) failed: \(error)")
+    }
+    return result
+}
+
+@discardableResult
+func run(_ sql: String, on connection: Connection) throws -> QueryResult {
+    return try check(synchronously { connection.execute(sql, onCompletion: $0) }, sql)
+}
+
+/// Read all the rows of a result, returning the number of rows.
+@discardableResult
+func drain(_ result: QueryResult) throws -> Int {
+    guard let resultSet = result.asResultSet else {
+        return 0
+    }
+    var rows = 0
+    while true {
+        let (row, error) = synchronously { (done: @escaping (([Any?]?, Error?)) -> ()) in
+            resultSet.nextRow(callback: done)
+        }
+        if let error = error {
+            throw BenchmarkError("Fetching a row failed: \(error)")
+        }
+        guard row != nil else {
+            return rows
+        }
+        rows += 1
+    }
+}
+
+func wideValue(row: Int, column: Int) -> Any {
+    switch column % 4 {
+    case 0:
+        return Int32(truncatingIfNeeded: row &* 31 &+ column)
+    case 1:
+        return Double(row) * 0.25 + Double(column)
+    case 2:
+        return "r\(row)c\(column)"
+    default:
+        return fixtureDate(row + column)
+    }
+}
+
+func fixtureDate(_ index: Int) -> Date {
+    return Date(timeIntervalSince1970: 1_500_000_000 + Double(index) * 37)
+}
+
+func fixtureBlob(_ index: Int, size: Int = FixtureSize.blobSize) -> Data {
+    return Data((0 ..< size).map { UInt8(truncatingIfNeeded: $0 &+ index) })
+}
+
+/// Create and fill the fixture tables, replacing any left over from an earlier run.
+func createFixtures(on connection: MySQLConnection) throws {
+    dropFixtures(on: connection)
+
+    try run("CREATE TABLE benchNarrow (id INT PRIMARY KEY, value INT)", on: connection)
+    try insert(into: "benchNarrow", columnCount: 2, rows: FixtureSize.narrowRows, on: connection) { row in
+        [Int32(row), Int32(truncatingIfNeeded: row &* 7)]
+    }
+
+    let wideColumns = (0 ..< FixtureSize.wideColumns).map { column -> String in
+        switch column % 4 {
+        case 0:
+            return "c\(column) INT"
+        case 1:
+            return "c\(column) DOUBLE"
+        case 2:
+            return "c\(column) VARCHAR(32)"
+        default:
+            return "c\(column) DATETIME"
+        }
+    }
+    try run("CREATE TABLE benchWide (" + wideColumns.joined(separator: ", ") + ")", on: connection)
+    try insert(into: "benchWide", columnCount: FixtureSize.wideColumns, rows: FixtureSize.wideRows, on: connection) { row in
+        (0 ..< FixtureSize.wideColumns).map { wideValue(row: row, column: $0) }
+    }
+
+    try run("CREATE TABLE benchTypes (id INT PRIMARY KEY, created DATETIME, payload BLOB)", on: connection)
+    try insert(into: "benchTypes", columnCount: 3, rows: FixtureSize.typesRows, on: connection) { row in
+        [Int32(row), fixtureDate(row), fixtureBlob(row)]
+    }
+
+    try run("CREATE TABLE benchBatch (id INT, name VARCHAR(32), value DOUBLE)", on: connection)
+}
+
+func dropFixtures(on connection: MySQLConnection) {
+    _ = try? run("DROP TABLE IF EXISTS benchNarrow, benchWide, benchTypes, benchBatch", on: connection)
+}
+
+private func insert(into table: String, columnCount: Int, rows: Int, on connection: MySQLConnection, values: (Int) -> [Any?]) throws {
+    let placeholders = [String](repeating: "?", count: columnCount).joined(separator: ", ")
+    let prepared = synchronously { connection.prepareStatement("INSERT INTO \(table) VALUES (\(placeholders))", onCompletion: $0) }
+    guard let statement = try check(prepared, "Preparing the insert into \(table)").asPreparedStatement else {
+        throw BenchmarkError("Preparing the insert into \(table) returned no statement")
+    }
+    defer {
+        _ = synchronously { connection.release(preparedStatement: statement, onCompletion: $0) }
+    }
+
+    // Insert in chunks so that a single call does not hold a large transaction
+    let chunkSize = 1000
+    var start = 0
+    while start < rows {
+        let parameterSets = (start ..< min(start + chunkSize, rows)).map(values)
+        try check(synchronously { connection.execute(preparedStatement: statement, parameterSets: parameterSets, onCompletion: $0) }, "Inserting into \(table)")
+        start += chunkSize
+    }
+}
@@ -0,0 +1,166 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import Foundation
+import SwiftKueryMySQL
+
+import CMySQL
+
+/// The options of a run, parsed from the command line. The connection defaults match
+/// Tests/SwiftKueryMySQLTests/connection.json and the mysql service of docker-compose.yml.
+struct BenchmarkOptions {
+    var host = "localhost"
+    var port = 3306
+    var user = "swift"
+    var password = "kuery"
+    var database = "test"
+    var iterations = 20
+    var filter: String? = nil
+    var output: String? = nil
+    var baseline: String? = nil
+    var tolerance = 0.10
+
+    static let usage = """
+        Usage: SwiftKueryMySQLBenchmarks [options]
+          --host <host>            MySQL host (localhost)
+          --port <port>            MySQL port (3306)
+          --user <user>            MySQL user (swift)
+          --password <password>    MySQL password (kuery)
+          --database <database>    MySQL database (test)
+          --iterations <count>     Measured iterations of each benchmark (20)
+          --filter <text>          Only run the benchmarks whose name contains <text>
+          --output <file>          Write the results as JSON to <file>
+          --baseline <file>        Compare the medians with the results in <file>, exiting with 1 on a regression
+          --tolerance <fraction>   The slowdown allowed against the baseline (0.10)
+        """
+
+    init(arguments: [String]) throws {
+        var remaining = arguments.makeIterator()
+        while let argument = remaining.next() {
+            if argument == "--help" {
+                throw BenchmarkError(BenchmarkOptions.usage)
+            }
+            guard argument.hasPrefix("--") else {
+                throw BenchmarkError("Unexpected argument \(argument)\n\(BenchmarkOptions.usage)")
+            }
+            guard let value = remaining.next() else {
+                throw BenchmarkError("Missing value for \(argument)\n\(BenchmarkOptions.usage)")
+            }
+            switch argument {
+            case "--host":
+                host = value
+            case "--port":
+                port = try BenchmarkOptions.number(value, argument)
+            case "--user":
+                user = value
+            case "--password":
+                password = value
+            case "--database":
+                database = value
+            case "--iterations":
+                iterations = max(try BenchmarkOptions.number(value, argument), 1)
+            case "--filter":
+                filter = value
+            case "--output":
+                output = value
+            case "--baseline":
+                baseline = value
+            case "--tolerance":
+                guard let fraction = Double(value), fraction >= 0 else {
+                    throw BenchmarkError("Invalid value \(value) for \(argument)")
+                }
+                tolerance = fraction
+            default:
+                throw BenchmarkError("Unknown option \(argument)\n\(BenchmarkOptions.usage)")
+            }
+        }
+    }
+
+    private static func number(_ value: String, _ argument: String) throws -> Int {
+        guard let number = Int(value) else {
+            throw BenchmarkError("Invalid value \(value) for \(argument)")
+        }
+        return number
+    }
+}
+
+func padded(_ name: String) -> String {
+    return name + String(repeating: " ", count: max(26 - name.count, 0))
+}
+
+func runBenchmarks() throws -> Int32 {
+    let options = try BenchmarkOptions(arguments: Array(CommandLine.arguments.dropFirst()))
+
+    let connection = MySQLConnection(host: options.host, user: options.user, password: options.password, database: options.database, port: options.port)
+    try check(connection.connectSync(), "Connecting to \(options.host):\(options.port)")
+    defer {
+        dropFixtures(on: connection)
+        connection.closeConnection()
+    }
+
+    var serverVersion = ""
+    let versionResult = try run("SELECT VERSION()", on: connection)
+    if let resultSet = versionResult.asResultSet {
+        let (row, _) = synchronously { (done: @escaping (([Any?]?, Error?)) -> ()) in resultSet.nextRow(callback: done) }
+        serverVersion = row?.first.flatMap { $0 }.map { String(describing: $0) } ?? ""
+        resultSet.done()
+    }
+
+    print("Creating fixtures")
+    try createFixtures(on: connection)
+
+    var results = [BenchmarkResult]()
+    for benchmark in benchmarks where options.filter.map({ benchmark.name.contains($0) }) ?? true {
+        let result = try benchmark.run(connection, options)
+        results.append(result)
+        print(padded(result.name) + String(format: " median %10.3f ms  p90 %10.3f ms  %12.0f items/s", result.median * 1000, result.p90 * 1000, result.itemsPerSecond))
+    }
+
+    let environment = [
+        ("client", String(cString: mysql_get_client_info())),
+        ("server", serverVersion),
+    ]
+    let output = json(environment: environment, iterations: options.iterations, results: results)
+    if let path = options.output {
+        try output.write(toFile: path, atomically: true, encoding: .utf8)
+        print("Results written to \(path)")
+    }
+
+    guard let baseline = options.baseline else {
+        return 0
+    }
+    let baselineMedians = try medians(fromFile: baseline)
+    var regressions = 0
+    for result in results {
+        guard let baselineMedian = baselineMedians[result.name], baselineMedian > 0 else {
+            continue
+        }
+        let ratio = result.median / baselineMedian
+        let regressed = ratio > 1 + options.tolerance
+        if regressed {
+            regressions += 1
+        }
+        print(padded(result.name) + String(format: " %+7.1f%% against the baseline", (ratio - 1) * 100) + (regressed ? " REGRESSION" : ""))
+    }
+    return regressions > 0 ? 1 : 0
+}
+
+do {
+    exit(try runBenchmarks())
+} catch {
+    print("ERROR: \(error)")
+    exit(2)
+}
@@ -11,5 +11,9 @@ XCTMain([
      testCase(TestSubquery.allTests),
      testCase(TestTransaction.allTests),
      testCase(TestColumnTypes.allTests),
-     testCase(TestSchema.allTests)
+     testCase(TestSchema.allTests),
+     testCase(TestStatementCache.allTests),
+     testCase(TestResultFetcher.allTests),
+     testCase(TestBulkOperations.allTests),
+     testCase(TestConnection.allTests)
 ])
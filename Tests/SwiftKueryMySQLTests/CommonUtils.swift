@@ -111,7 +111,7 @@ func cleanUp(table: String, connection: Connection, callback: @escaping (QueryRe
     }
 }
 
-private func printResultAndGetRowsAsArray(_ result: QueryResult, callback: @escaping (QueryResult, [[Any?]]?)->()) {
+func printResultAndGetRowsAsArray(_ result: QueryResult, callback: @escaping (QueryResult, [[Any?]]?)->()) {
     var rows: [[Any?]] = [[Any?]]()
     if let resultSet = result.asResultSet {
         resultSet.getColumnTitles() { titles, error in
@@ -225,4 +225,46 @@ class CommonUtils {
         }
         return pool!
     }
+
+    func getConnection(targetQueue: DispatchQueue? = nil) -> MySQLConnection? {
+        do {
+            let connectionFile = #file.replacingOccurrences(of: "CommonUtils.swift", with: "connection.json")
+            let data = Data(referencing: try NSData(contentsOfFile: connectionFile))
+            let json = try JSONSerialization.jsonObject(with: data)
+
+            guard let dictionary = json as? [String: String] else {
+                XCTFail("Invalid format for connection.json contents: \(json)")
+                return nil
+            }
+            var port: Int? = nil
+            if let portString = dictionary["port"] {
+                port = Int(portString)
+            }
+            return MySQLConnection(host: dictionary["host"], user: dictionary["username"], password: dictionary["password"], database: dictionary["database"], port: port, targetQueue: targetQueue)
+        } catch {
+            XCTFail(error.localizedDescription)
+            return nil
+        }
+    }
+
+    func getConnectionPool(poolOptions: ConnectionPoolOptions, mysqlPoolOptions: MySQLPoolOptions) -> ConnectionPool? {
+        do {
+            let connectionFile = #file.replacingOccurrences(of: "CommonUtils.swift", with: "connection.json")
+            let data = Data(referencing: try NSData(contentsOfFile: connectionFile))
+            let json = try JSONSerialization.jsonObject(with: data)
+
+            guard let dictionary = json as? [String: String] else {
+                XCTFail("Invalid format for connection.json contents: \(json)")
+                return nil
+            }
+            var port: Int? = nil
+            if let portString = dictionary["port"] {
+                port = Int(portString)
+            }
+            return MySQLConnection.createPool(host: dictionary["host"], user: dictionary["username"], password: dictionary["password"], database: dictionary["database"], port: port, poolOptions: poolOptions, mysqlPoolOptions: mysqlPoolOptions)
+        } catch {
+            XCTFail(error.localizedDescription)
+            return nil
+        }
+    }
 }
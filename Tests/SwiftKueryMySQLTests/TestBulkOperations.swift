@@ -0,0 +1,271 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import XCTest
+import Foundation
+import SwiftKuery
+import SwiftKueryMySQL
+
+#if os(Linux)
+let tableBulkOperations = "tableBulkOperationsLinux"
+#else
+let tableBulkOperations = "tableBulkOperationsOSX"
+#endif
+
+class TestBulkOperations: XCTestCase {
+
+    static var allTests: [(String, (TestBulkOperations) -> () throws -> Void)] {
+        return [
+            ("testParameterSets", testParameterSets),
+            ("testMultiRowInsert", testMultiRowInsert),
+            ("testBulkLoad", testBulkLoad),
+            ("testMultiRowInsertIDs", testMultiRowInsertIDs),
+        ]
+    }
+
+    class MyTable : Table {
+        let a = Column("a", Varchar.self, length: 10)
+        let b = Column("b", Int32.self)
+
+        let tableName = tableBulkOperations
+    }
+
+    class IDTable : Table {
+        let id = Column("id", Int32.self, autoIncrement: true, primaryKey: true)
+        let b = Column("b", Int32.self)
+
+        let tableName = tableBulkOperations + "IDs"
+    }
+
+    class DateTable : Table {
+        let d = Column("d")
+
+        let tableName = tableBulkOperations + "Dates"
+    }
+
+    func testParameterSets() {
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    if let error = result.asError {
+                        XCTFail("Error in CREATE TABLE: \(error)")
+                        return
+                    }
+
+                    let i1 = Insert(into: t, values: Parameter(), Parameter())
+                    connection.prepareStatement(i1) { result in
+                        guard let statement = result.asPreparedStatement else {
+                            XCTFail("Unable to prepare statement: \(String(describing: result.asError))")
+                            return
+                        }
+                        let parameterSets: [[Any?]] = (1...20).map { ["fruit\($0)", $0] }
+                        connection.execute(preparedStatement: statement, parameterSets: parameterSets) { result in
+                            XCTAssertNil(result.asError, "Error in batched INSERT: \(result.asError!)")
+                            XCTAssertEqual(result.asValue as? String, "20 rows affected", "Wrong number of affected rows")
+
+                            connection.execute(preparedStatement: statement, parameterSets: [["fruit21", 21], ["fruit22"]]) { result in
+                                XCTAssertNotNil(result.asError, "Parameter sets of different sizes did not fail")
+
+                                connection.release(preparedStatement: statement) { _ in
+                                    let s1 = Select(from: t)
+                                    executeQuery(query: s1, connection: connection) { result, rows in
+                                        XCTAssertEqual(rows?.count, 21, "SELECT returned wrong number of rows: \(String(describing: rows?.count)) instead of 21")
+
+                                        cleanUp(table: t.tableName, connection: connection) { _ in
+                                            expectation.fulfill()
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testMultiRowInsert() {
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.statementCacheSize = 4
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    if let error = result.asError {
+                        XCTFail("Error in CREATE TABLE: \(error)")
+                        return
+                    }
+
+                    // More rows than fit in a single statement with 2 parameters per row
+                    let rowCount = 40_000
+                    let parameterSets: [[Any?]] = (0 ..< rowCount).map { [$0 % 3 == 0 ? nil : "fruit", $0] }
+                    connection.execute(insert: Insert(into: t, columns: [t.a, t.b], values: []), parameterSets: parameterSets) { result in
+                        XCTAssertNil(result.asError, "Error in multi-row INSERT: \(result.asError!)")
+                        XCTAssertEqual(result.asValue as? String, "\(rowCount) rows affected", "Wrong number of affected rows")
+
+                        executeRawQuery("SELECT COUNT(*), COUNT(a), SUM(b) FROM " + packName(t.tableName), connection: connection) { result, rows in
+                            XCTAssertEqual(rows?[0][0] as? Int64, Int64(rowCount), "Wrong number of rows inserted")
+                            XCTAssertEqual(rows?[0][1] as? Int64, Int64(rowCount - (rowCount + 2) / 3), "Wrong number of NULL values inserted")
+                            XCTAssertEqual(rows?[0][2] as? String, "\(rowCount * (rowCount - 1) / 2)", "Rows inserted with wrong values")
+
+                            cleanUp(table: t.tableName, connection: connection) { _ in
+                                expectation.fulfill()
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testBulkLoad() {
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.allowLocalInfile = true
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        let rowCount = 100_000
+        let rows = (0 ..< rowCount).lazy.map { i -> [Any?] in [i % 2 == 0 ? "a\tb\\c" : nil, i] }
+
+        performTest(asyncTasks: { expectation in
+            // The server must allow local infile requests, which is off by default from MySQL 8.0
+            executeRawQuery("SET GLOBAL local_infile = 1", connection: connection) { _, _ in
+                cleanUp(table: t.tableName, connection: connection) { _ in
+                    t.create(connection: connection) { result in
+                        if let error = result.asError {
+                            XCTFail("Error in CREATE TABLE: \(error)")
+                            return
+                        }
+
+                        connection.load(into: t, rows: rows) { result, error in
+                            XCTAssertNil(error, "Error in bulk load: \(error!)")
+                            XCTAssertEqual(result?.rowCount, UInt64(rowCount), "Wrong number of rows loaded")
+                            XCTAssertEqual(result?.warningCount, 0, "Warnings raised by bulk load")
+
+                            let stream = InputStream(data: "x\t-1\n\\N\t-2\n".data(using: .utf8)!)
+                            connection.load(into: t, columns: [t.a, t.b], from: stream) { result, error in
+                                XCTAssertNil(error, "Error in bulk load: \(error!)")
+                                XCTAssertEqual(result?.rowCount, 2, "Wrong number of rows loaded from stream")
+
+                                executeRawQuery("SELECT a, COUNT(*), SUM(b) FROM " + packName(t.tableName) + " GROUP BY a ORDER BY a", connection: connection) { result, rows in
+                                    XCTAssertEqual(rows?.count, 3, "Wrong number of distinct values loaded")
+                                    XCTAssertNil(rows?[0][0] ?? nil, "Wrong NULL value loaded")
+                                    XCTAssertEqual(rows?[0][1] as? Int64, Int64(rowCount / 2 + 1), "Wrong number of NULL values loaded")
+                                    XCTAssertEqual(rows?[1][0] as? String, "a\tb\\c", "Escaped value not loaded correctly")
+                                    XCTAssertEqual(rows?[2][0] as? String, "x", "Wrong value loaded from stream")
+
+                                    self.loadDates(connection: connection) {
+                                        cleanUp(table: t.tableName, connection: connection) { _ in
+                                            expectation.fulfill()
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    /// Load a DATETIME value late in the month, whose day must not be counted in its hours.
+    func loadDates(connection: MySQLConnection, onCompletion: @escaping () -> ()) {
+        let t = DateTable()
+
+        // 2019-03-31 01:30:45 UTC
+        let date = Date(timeIntervalSince1970: 1_553_995_845)
+
+        cleanUp(table: t.tableName, connection: connection) { _ in
+            executeRawQuery("CREATE TABLE " + packName(t.tableName) + " (d datetime)", connection: connection) { result, rows in
+                XCTAssertEqual(result.success, true, "CREATE TABLE failed")
+
+                connection.load(into: t, rows: [[date]]) { result, error in
+                    XCTAssertNil(error, "Error in bulk load: \(error!)")
+                    XCTAssertEqual(result?.rowCount, 1, "Wrong number of DATETIME rows loaded")
+                    XCTAssertEqual(result?.warningCount, 0, "Warnings raised by bulk load of DATETIME value")
+
+                    executeRawQuery("SELECT d FROM " + packName(t.tableName), connection: connection) { result, rows in
+                        XCTAssertEqual(rows?[0][0] as? Date, date, "Wrong DATETIME value loaded")
+
+                        cleanUp(table: t.tableName, connection: connection) { _ in
+                            onCompletion()
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    func testMultiRowInsertIDs() {
+        let t = IDTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    if let error = result.asError {
+                        XCTFail("Error in CREATE TABLE: \(error)")
+                        return
+                    }
+
+                    let parameterSets: [[Any?]] = (1...5).map { [$0] }
+                    let insert = Insert(into: t, columns: [t.b], values: [], returnID: true)
+                    connection.execute(insert: insert, parameterSets: parameterSets) { result in
+                        XCTAssertNil(result.asError, "Error in multi-row INSERT: \(result.asError!)")
+                        printResultAndGetRowsAsArray(result) { result, rows in
+                            XCTAssertEqual(rows?.map { $0[0] as? Int64 ?? 0 } ?? [], Array(1...5), "Wrong IDs returned")
+
+                            cleanUp(table: t.tableName, connection: connection) { _ in
+                                expectation.fulfill()
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+}
@@ -348,9 +348,9 @@ class TestColumnTypes: XCTestCase {
 
                         let rawInsert = "INSERT INTO " + t.tableName + " (idCol, blobCol) VALUES (?, ?)"
 
-                        let insertedBlobs = [Data(repeating: 0x84, count: 10), Data(repeating: 0x70, count: 10000), Data(repeating: 0x52, count: 1), Data(repeating: 0x40, count: 10000)]
+                        let insertedBlobs = [Data(repeating: 0x84, count: 10), Data(repeating: 0x70, count: 10000), Data(repeating: 0x52, count: 1), Data(repeating: 0x40, count: 10000), Data()]
 
-                        let parametersArray = [[0, insertedBlobs[0]], [1, [UInt8](insertedBlobs[1])], [2, insertedBlobs[2]], [3, insertedBlobs[3]]]
+                        let parametersArray = [[0, insertedBlobs[0]], [1, [UInt8](insertedBlobs[1])], [2, insertedBlobs[2]], [3, insertedBlobs[3]], [4, insertedBlobs[4]]]
 
                         connection.prepareStatement(rawInsert) { result in
                             guard let preparedStatement = result.asPreparedStatement else {
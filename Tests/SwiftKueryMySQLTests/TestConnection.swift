@@ -0,0 +1,395 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import XCTest
+import Foundation
+import Dispatch
+import SwiftKuery
+import SwiftKueryMySQL
+
+#if os(Linux)
+let tableRouting = "tableRoutingLinux"
+#else
+let tableRouting = "tableRoutingOSX"
+#endif
+
+class TestConnection: XCTestCase {
+
+    static var allTests: [(String, (TestConnection) -> () throws -> Void)] {
+        return [
+            ("testConcurrentUse", testConcurrentUse),
+            ("testNonBlocking", testNonBlocking),
+            ("testPipeline", testPipeline),
+            ("testLiveness", testLiveness),
+            ("testPoolOptions", testPoolOptions),
+            ("testConnectionOptions", testConnectionOptions),
+            ("testInitCommands", testInitCommands),
+            ("testRoutingPool", testRoutingPool),
+            ("testPartitionedScan", testPartitionedScan),
+            ("testInstrumentation", testInstrumentation),
+        ]
+    }
+
+    func testConcurrentUse() {
+        let targetQueue = DispatchQueue(label: "TestConnection.target", attributes: .concurrent)
+        guard let connection = CommonUtils.sharedInstance.getConnection(targetQueue: targetQueue) else {
+            return
+        }
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            // Operations issued concurrently from many threads are run one at a time on the connection
+            let group = DispatchGroup()
+            let lock = NSLock()
+            var values = [Int64]()
+            DispatchQueue.concurrentPerform(iterations: 50) { i in
+                group.enter()
+                executeRawQueryWithParameters("SELECT ? + 1", connection: connection, parameters: [Int64(i)]) { result, rows in
+                    XCTAssertNil(result.asError, "Error in SELECT: \(result.asError!)")
+                    lock.lock()
+                    if let value = rows?.first?.first as? Int64 {
+                        values.append(value)
+                    }
+                    lock.unlock()
+                    group.leave()
+                }
+            }
+            group.notify(queue: DispatchQueue.global()) {
+                XCTAssertEqual(values.sorted(), Array(1...50), "Wrong results from concurrent queries")
+                // Synchronous calls from a completion handler running on the connection's queue do not deadlock
+                connection.execute("SELECT 1") { _ in
+                    XCTAssertTrue(connection.isConnected, "Connection not connected")
+                    expectation.fulfill()
+                }
+            }
+        })
+    }
+
+    func testNonBlocking() {
+        guard MySQLEventLoop.isSupported, let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.eventLoop = MySQLEventLoop()
+
+        performTest(asyncTasks: { expectation in
+            connection.connect { result in
+                XCTAssertEqual(result.success, true, "Failed to connect")
+                executeRawQuery("SELECT 1 + 1 AS a, 'text' AS b, NULL AS c", connection: connection) { result, rows in
+                    XCTAssertNil(result.asError, "Error in SELECT: \(result.asError!)")
+                    XCTAssertEqual(rows?.count, 1, "Wrong number of rows")
+                    if let row = rows?.first {
+                        XCTAssertEqual(row[0] as? Int64, 2, "Wrong value in column a")
+                        XCTAssertEqual(row[1] as? String, "text", "Wrong value in column b")
+                        XCTAssertNil(row[2], "Wrong value in column c")
+                    }
+                    executeRawQuery("SELECT * FROM no_such_table_exists", connection: connection) { result, _ in
+                        XCTAssertNotNil(result.asError, "Expected an error for a missing table")
+                        connection.closeConnection()
+                        expectation.fulfill()
+                    }
+                }
+            }
+        })
+    }
+
+    func testPipeline() {
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            let statements = ["SELECT 1", "SELECT * FROM no_such_table_exists", "SELECT 'b'", "DO 1"]
+            connection.execute(pipeline: statements) { results in
+                XCTAssertEqual(results.count, statements.count, "Wrong number of results")
+                guard results.count == statements.count else {
+                    return expectation.fulfill()
+                }
+                // The failure of the second statement does not prevent the following ones from running
+                XCTAssertNotNil(results[1].asError, "Expected an error for a missing table")
+                XCTAssertNil(results[3].asError, "Error in DO: \(results[3].asError!)")
+                printResultAndGetRowsAsArray(results[0]) { result, rows in
+                    XCTAssertEqual(rows?.first?.first as? Int64, 1, "Wrong value in first result")
+                    printResultAndGetRowsAsArray(results[2]) { result, rows in
+                        XCTAssertEqual(rows?.first?.first as? String, "b", "Wrong value in third result")
+                        // Multiple statements are not allowed outside of pipelines
+                        executeRawQuery("SELECT 1; SELECT 2", connection: connection) { result, _ in
+                            XCTAssertNotNil(result.asError, "Multiple statements allowed outside of a pipeline")
+                            expectation.fulfill()
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testLiveness() {
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        XCTAssertFalse(connection.isConnected, "Connection connected before connect")
+        XCTAssertFalse(connection.validate(), "Connection validated before connect")
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+
+        XCTAssertTrue(connection.isConnected, "Connection not connected after connect")
+        XCTAssertTrue(connection.validate(), "Connection not validated after connect")
+        connection.pingInterval = 0
+        XCTAssertTrue(connection.isConnected, "Connection not connected with ping on every check")
+
+        connection.closeConnection()
+        XCTAssertFalse(connection.isConnected, "Connection connected after close")
+        XCTAssertFalse(connection.validate(), "Connection validated after close")
+    }
+
+    func testPoolOptions() {
+        let poolOptions = ConnectionPoolOptions(initialCapacity: 3, maxCapacity: 4)
+        let mysqlPoolOptions = MySQLPoolOptions(spareConnections: 1, validationInterval: 1, maxLifetime: 60, idleTimeout: 30)
+        guard let pool = CommonUtils.sharedInstance.getConnectionPool(poolOptions: poolOptions, mysqlPoolOptions: mysqlPoolOptions) else {
+            return
+        }
+
+        performTest(asyncTasks: { expectation in
+            pool.getConnection { connection, error in
+                guard let connection = connection else {
+                    XCTFail("Failed to get connection: \(String(describing: error))")
+                    return
+                }
+                XCTAssertTrue(connection.isConnected, "Prefilled connection not connected")
+                executeRawQuery("SELECT 1", connection: connection) { result, rows in
+                    XCTAssertNil(result.asError, "Error in SELECT: \(result.asError!)")
+                    XCTAssertEqual(rows?.first?.first as? Int64, 1, "Wrong value returned")
+                    connection.closeConnection()
+                    expectation.fulfill()
+                }
+            }
+        })
+    }
+
+    class RoutingTable : Table {
+        let a = Column("a", Int32.self)
+
+        let tableName = tableRouting
+    }
+
+    func testConnectionOptions() {
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.connectionOptions = MySQLConnectionOptions(compression: [.zlib], readTimeout: 30, writeTimeout: 30)
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            executeRawQuery("SHOW SESSION STATUS LIKE 'Compression'", connection: connection) { result, rows in
+                XCTAssertNil(result.asError, "Error in SHOW STATUS: \(result.asError!)")
+                XCTAssertEqual(rows?.first?[1] as? String, "ON", "Connection not compressed")
+                expectation.fulfill()
+            }
+        })
+    }
+
+    func testInitCommands() {
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.connectionOptions = MySQLConnectionOptions(initCommands: ["SET @kuery_init = 'ready'", "SET @kuery_second = 'also'"])
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            executeRawQuery("SELECT @kuery_init, @kuery_second, @@character_set_client", connection: connection) { result, rows in
+                XCTAssertNil(result.asError, "Error in SELECT: \(result.asError!)")
+                XCTAssertEqual(rows?.first?[0] as? String, "ready", "Init command not executed")
+                XCTAssertEqual(rows?.first?[1] as? String, "also", "Second init command not executed")
+                // The character set is sent in the handshake
+                XCTAssertEqual((rows?.first?[2] as? String)?.hasPrefix("utf8"), true, "Wrong character set: \(String(describing: rows?.first?[2]))")
+                expectation.fulfill()
+            }
+        })
+    }
+
+    func testRoutingPool() {
+        let t = RoutingTable()
+        let poolOptions = ConnectionPoolOptions(initialCapacity: 1, maxCapacity: 2)
+        // The same server stands in for the primary and the replica
+        guard let primary = CommonUtils.sharedInstance.getConnectionPool(poolOptions: poolOptions, mysqlPoolOptions: MySQLPoolOptions()),
+            let replica = CommonUtils.sharedInstance.getConnectionPool(poolOptions: poolOptions, mysqlPoolOptions: MySQLPoolOptions()) else {
+            return
+        }
+        let pool = MySQLRoutingPool(primary: primary, replicas: [replica], options: MySQLRoutingOptions(readYourWritesWindow: 1))
+
+        performTest(asyncTasks: { expectation in
+            pool.getConnection { connection, error in
+                guard let connection = connection else {
+                    XCTFail("Failed to get connection: \(String(describing: error))")
+                    return
+                }
+                cleanUp(table: t.tableName, connection: connection) { _ in
+                    t.create(connection: connection) { result in
+                        XCTAssertNil(result.asError, "Error in CREATE TABLE: \(result.asError!)")
+                        executeQuery(query: Insert(into: t, values: 1), connection: connection) { result, _ in
+                            XCTAssertNil(result.asError, "Error in INSERT: \(result.asError!)")
+                            // The read follows the write on the primary
+                            executeQuery(query: Select(from: t), connection: connection) { result, rows in
+                                XCTAssertNil(result.asError, "Error in SELECT: \(result.asError!)")
+                                XCTAssertEqual(rows?.count, 1, "Row written not read")
+                                connection.startTransaction { result in
+                                    XCTAssertNil(result.asError, "Error in START TRANSACTION: \(result.asError!)")
+                                    executeQuery(query: Select(from: t), connection: connection) { result, rows in
+                                        XCTAssertEqual(rows?.count, 1, "Wrong number of rows in transaction")
+                                        connection.commit { result in
+                                            XCTAssertNil(result.asError, "Error in COMMIT: \(result.asError!)")
+                                            cleanUp(table: t.tableName, connection: connection) { _ in
+                                                connection.closeConnection()
+                                                expectation.fulfill()
+                                            }
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func readAll(_ scan: MySQLPartitionedScan, rows: [[Any?]] = [], onCompletion: @escaping ([[Any?]], Error?) -> ()) {
+        scan.fetchNextBatch { batch, error in
+            guard let batch = batch else {
+                return onCompletion(rows, error)
+            }
+            self.readAll(scan, rows: rows + batch, onCompletion: onCompletion)
+        }
+    }
+
+    func testPartitionedScan() {
+        let t = RoutingTable()
+        let poolOptions = ConnectionPoolOptions(initialCapacity: 1, maxCapacity: 4)
+        guard let pool = CommonUtils.sharedInstance.getConnectionPool(poolOptions: poolOptions, mysqlPoolOptions: MySQLPoolOptions()) else {
+            return
+        }
+
+        performTest(asyncTasks: { expectation in
+            pool.getConnection { connection, error in
+                guard let connection = connection else {
+                    XCTFail("Failed to get connection: \(String(describing: error))")
+                    return
+                }
+                cleanUp(table: t.tableName, connection: connection) { _ in
+                    t.create(connection: connection) { result in
+                        XCTAssertNil(result.asError, "Error in CREATE TABLE: \(result.asError!)")
+                        executeQuery(query: Insert(into: t, rows: (1...100).map { [$0] }), connection: connection) { result, _ in
+                            XCTAssertNil(result.asError, "Error in INSERT: \(result.asError!)")
+                            connection.closeConnection()
+
+                            pool.scan(Select(from: t).order(by: .ASC(t.a)), key: t.a, partitions: 4, batchSize: 10, order: .keyOrder) { scan, error in
+                                guard let scan = scan else {
+                                    XCTFail("Failed to start scan: \(String(describing: error))")
+                                    return
+                                }
+                                XCTAssertEqual(scan.partitionCount, 4, "Wrong number of partitions")
+                                self.readAll(scan) { rows, error in
+                                    XCTAssertNil(error, "Error reading partitions: \(String(describing: error))")
+                                    XCTAssertEqual(rows.map { $0[0] as? Int32 }, (1...100).map { Int32($0) }, "Rows of the partitions not returned in key order")
+
+                                    // A Select with a where clause is filtered as a derived table
+                                    pool.scan(Select(from: t).where(t.a > 50), key: t.a, partitions: 3) { scan, error in
+                                        guard let scan = scan else {
+                                            XCTFail("Failed to start scan: \(String(describing: error))")
+                                            return
+                                        }
+                                        self.readAll(scan) { rows, error in
+                                            XCTAssertNil(error, "Error reading partitions: \(String(describing: error))")
+                                            XCTAssertEqual(rows.map { ($0[0] as? Int32) ?? 0 }.sorted(), (51...100).map { Int32($0) }, "Wrong rows returned")
+
+                                            pool.getConnection { connection, _ in
+                                                guard let connection = connection else {
+                                                    return
+                                                }
+                                                cleanUp(table: t.tableName, connection: connection) { _ in
+                                                    connection.closeConnection()
+                                                    expectation.fulfill()
+                                                }
+                                            }
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    class Recorder: MySQLInstrumentation {
+        let lock = NSLock()
+        var executions = [MySQLStatementMetrics]()
+        var fetches = [MySQLFetchMetrics]()
+
+        func didExecute(_ metrics: MySQLStatementMetrics) {
+            lock.lock()
+            executions.append(metrics)
+            lock.unlock()
+        }
+
+        func didFetch(_ metrics: MySQLFetchMetrics) {
+            lock.lock()
+            fetches.append(metrics)
+            lock.unlock()
+        }
+    }
+
+    func testInstrumentation() {
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        let recorder = Recorder()
+        connection.instrumentation = recorder
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            executeRawQueryWithParameters("SELECT ? AS a UNION ALL SELECT 'bb'", connection: connection, parameters: ["a"]) { result, rows in
+                XCTAssertNil(result.asError, "Error in SELECT: \(result.asError!)")
+                XCTAssertEqual(rows?.count, 2, "Wrong number of rows")
+                recorder.lock.lock()
+                XCTAssertEqual(recorder.executions.count, 1, "Execution not reported")
+                XCTAssertEqual(recorder.executions.first?.succeeded, true, "Execution reported as failed")
+                XCTAssertEqual(recorder.executions.first?.sql, "SELECT ? AS a UNION ALL SELECT 'bb'", "Wrong SQL reported")
+                XCTAssertEqual(recorder.fetches.count, 1, "Fetch not reported")
+                XCTAssertEqual(recorder.fetches.first?.rowCount, 2, "Wrong number of rows reported")
+                XCTAssertEqual(recorder.fetches.first?.bytesReceived, 3, "Wrong number of bytes reported")
+                XCTAssertNotNil(recorder.fetches.first?.timeToFirstRow, "Time to first row not reported")
+                recorder.lock.unlock()
+                expectation.fulfill()
+            }
+        })
+    }
+}
@@ -15,15 +15,18 @@
  */
 
 import XCTest
+import Foundation
 import SwiftKuery
 import SwiftKueryMySQL
 
 #if os(Linux)
 let tableParameters = "tableParametersLinux"
 let tableNamedParameters = "tableNamedParametersLinux"
+let tableBindingParameters = "tableBindingParametersLinux"
 #else
 let tableParameters = "tableParametersOSX"
 let tableNamedParameters = "tableNamedParametersOSX"
+let tableBindingParameters = "tableBindingParametersOSX"
 #endif
 
 class TestParameters: XCTestCase {
@@ -33,6 +36,7 @@ class TestParameters: XCTestCase {
             ("testParameters", testParameters),
             ("testMultipleParameterSets", testMultipleParameterSets),
             ("testNamedParameters", testNamedParameters),
+            ("testRepeatedBindings", testRepeatedBindings),
         ]
     }
 
@@ -287,4 +291,80 @@ class TestParameters: XCTestCase {
             }
         })
     }
+
+    class BindingTable: Table {
+        let a = Column("a")
+        let b = Column("b")
+        let c = Column("c")
+
+        let tableName = tableBindingParameters
+    }
+
+    func testRepeatedBindings() {
+        let t = BindingTable()
+
+        let large = Data((0 ..< 4096).map { UInt8(truncatingIfNeeded: $0) })
+        let small = Data([1, 2, 3])
+        let parametersArray: [[Any?]] = [
+            ["apple", 10, large],
+            [nil, "3", small],
+            ["banana€euro", Int8(-8), nil],
+            [String(repeating: "x", count: 40), UInt16(7), Data(large.reversed())],
+        ]
+
+        let pool = CommonUtils.sharedInstance.getConnectionPool()
+        performTest(asyncTasks: { expectation in
+
+            pool.getConnection { connection, error in
+                guard let connection = connection else {
+                    XCTFail("Failed to get connection")
+                    return
+                }
+                cleanUp(table: t.tableName, connection: connection) { _ in
+
+                    executeRawQuery("CREATE TABLE " +  packName(t.tableName) + " (a varchar(40), b integer, c blob) CHARACTER SET utf8", connection: connection) { result, rows in
+                        XCTAssertEqual(result.success, true, "CREATE TABLE failed")
+                        XCTAssertNil(result.asError, "Error in CREATE TABLE: \(result.asError!)")
+
+                        let i1 = "insert into " + t.tableName + " values(?, ?, ?)"
+                        connection.prepareStatement(i1) { result in
+                            guard let preparedStatement = result.asPreparedStatement else {
+                                XCTFail("Error in INSERT: \(String(describing: result.asError))")
+                                return
+                            }
+                            // Each slot is bound to values of different types and sizes in turn, reusing its buffer
+                            self.executePreparedStatementWithParameterArray(statement: preparedStatement, count: parametersArray.count, params: parametersArray, connection: connection) { result in
+                                XCTAssertNil(result.asError, "Error in INSERT: \(String(describing: result.asError))")
+                                connection.release(preparedStatement: preparedStatement) { _ in
+                                    let s1 = Select(from: t)
+                                    executeQuery(query: s1, connection: connection) { result, rows in
+                                        XCTAssertEqual(result.success, true, "SELECT failed")
+                                        XCTAssertEqual(rows?.count, 4, "SELECT returned wrong number of rows: \(String(describing: rows?.count)) instead of 4")
+                                        if let rows = rows, rows.count == 4 {
+                                            XCTAssertEqual(rows[0][0] as? String, "apple", "Wrong value in row 0 column 0")
+                                            XCTAssertEqual(rows[0][1] as? Int32, 10, "Wrong value in row 0 column 1")
+                                            XCTAssertEqual(rows[0][2] as? Data, large, "Wrong value in row 0 column 2")
+                                            XCTAssertNil(rows[1][0], "Wrong value in row 1 column 0")
+                                            XCTAssertEqual(rows[1][1] as? Int32, 3, "Wrong value in row 1 column 1")
+                                            XCTAssertEqual(rows[1][2] as? Data, small, "Wrong value in row 1 column 2")
+                                            XCTAssertEqual(rows[2][0] as? String, "banana€euro", "Wrong value in row 2 column 0")
+                                            XCTAssertEqual(rows[2][1] as? Int32, -8, "Wrong value in row 2 column 1")
+                                            XCTAssertNil(rows[2][2], "Wrong value in row 2 column 2")
+                                            XCTAssertEqual(rows[3][0] as? String, String(repeating: "x", count: 40), "Wrong value in row 3 column 0")
+                                            XCTAssertEqual(rows[3][1] as? Int32, 7, "Wrong value in row 3 column 1")
+                                            XCTAssertEqual(rows[3][2] as? Data, Data(large.reversed()), "Wrong value in row 3 column 2")
+                                        }
+
+                                        cleanUp(table: t.tableName, connection: connection) { _ in
+                                            expectation.fulfill()
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
 }
@@ -0,0 +1,694 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import XCTest
+import Foundation
+import SwiftKuery
+import SwiftKueryMySQL
+
+#if os(Linux)
+let tableResultFetcher = "tableResultFetcherLinux"
+#else
+let tableResultFetcher = "tableResultFetcherOSX"
+#endif
+
+class TestResultFetcher: XCTestCase {
+
+    static var allTests: [(String, (TestResultFetcher) -> () throws -> Void)] {
+        return [
+            ("testFetchBatches", testFetchBatches),
+            ("testBufferedResults", testBufferedResults),
+            ("testTitlesAfterBufferedResult", testTitlesAfterBufferedResult),
+            ("testCursorFetch", testCursorFetch),
+            ("testLongValues", testLongValues),
+            ("testFetchColumns", testFetchColumns),
+            ("testFetchColumnsBuffered", testFetchColumnsBuffered),
+            ("testTypeOptions", testTypeOptions),
+            ("testRowBatches", testRowBatches),
+            ("testDecimals", testDecimals),
+            ("testMemoryBudget", testMemoryBudget),
+        ]
+    }
+
+    class MyTable : Table {
+        let a = Column("a", Varchar.self, length: 10)
+        let b = Column("b", Int32.self)
+
+        let tableName = tableResultFetcher
+    }
+
+    func fetchAll(_ fetcher: MySQLResultFetcher, batchSize: Int, batches: [[[Any?]]] = [], onCompletion: @escaping ([[[Any?]]], Error?) -> ()) {
+        fetcher.fetchNext(batchSize: batchSize) { result in
+            guard let rows = result.0 else {
+                return onCompletion(batches, result.1)
+            }
+            self.fetchAll(fetcher, batchSize: batchSize, batches: batches + [rows], onCompletion: onCompletion)
+        }
+    }
+
+    func testFetchBatches() {
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    if let error = result.asError {
+                        XCTFail("Error in CREATE TABLE: \(error)")
+                        return
+                    }
+
+                    let rows: [[Any]] = (1...7).map { ["fruit\($0)", $0] }
+                    let i1 = Insert(into: t, rows: rows)
+                    executeQuery(query: i1, connection: connection) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+
+                        let s1 = Select(from: t).order(by: .ASC(t.b))
+                        connection.fetch(query: s1) { fetcher, error in
+                            guard let fetcher = fetcher else {
+                                XCTFail("No result fetcher returned: \(String(describing: error))")
+                                return
+                            }
+                            self.fetchAll(fetcher, batchSize: 3) { batches, error in
+                                XCTAssertNil(error, "Error fetching rows: \(String(describing: error))")
+                                XCTAssertEqual(batches.map { $0.count }, [3, 3, 1], "Wrong batch sizes")
+                                XCTAssertEqual(batches.last?.last?[0] as? String, "fruit7", "Wrong value in last row column 0")
+                                XCTAssertEqual(batches.last?.last?[1] as? Int32, 7, "Wrong value in last row column 1")
+
+                                cleanUp(table: t.tableName, connection: connection) { _ in
+                                    expectation.fulfill()
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testBufferedResults() {
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.resultBuffering = .buffered
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    if let error = result.asError {
+                        XCTFail("Error in CREATE TABLE: \(error)")
+                        return
+                    }
+
+                    let rows: [[Any]] = (1...5).map { ["fruit\($0)", $0] }
+                    let i1 = Insert(into: t, rows: rows)
+                    executeQuery(query: i1, connection: connection) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+
+                        let s1 = Select(from: t).order(by: .ASC(t.b))
+                        connection.fetch(query: s1) { fetcher, error in
+                            guard let fetcher = fetcher else {
+                                XCTFail("No result fetcher returned: \(String(describing: error))")
+                                return
+                            }
+                            XCTAssertEqual(fetcher.rowCount, 5, "Wrong row count for buffered result")
+
+                            // The connection is not tied up by the unconsumed buffered result
+                            let u1 = Update(t, set: [(t.b, 0)], where: t.a == "fruit1")
+                            executeQuery(query: u1, connection: connection) { result, rows in
+                                XCTAssertEqual(result.success, true, "UPDATE failed")
+                                XCTAssertNil(result.asError, "Error in UPDATE: \(result.asError!)")
+
+                                self.fetchAll(fetcher, batchSize: 2) { batches, error in
+                                    XCTAssertNil(error, "Error fetching rows: \(String(describing: error))")
+                                    XCTAssertEqual(batches.map { $0.count }, [2, 2, 1], "Wrong batch sizes")
+                                    XCTAssertEqual(batches.first?.first?[1] as? Int32, 1, "Buffered result changed after it was read")
+
+                                    cleanUp(table: t.tableName, connection: connection) { _ in
+                                        expectation.fulfill()
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testTitlesAfterBufferedResult() {
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.resultBuffering = .buffered
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    if let error = result.asError {
+                        XCTFail("Error in CREATE TABLE: \(error)")
+                        return
+                    }
+
+                    let rows: [[Any]] = (1...3).map { ["fruit\($0)", $0] }
+                    let i1 = Insert(into: t, rows: rows)
+                    executeQuery(query: i1, connection: connection) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+
+                        let s1 = Select(from: t).order(by: .ASC(t.b))
+                        connection.fetch(query: s1) { fetcher, error in
+                            guard let fetcher = fetcher else {
+                                XCTFail("No result fetcher returned: \(String(describing: error))")
+                                return
+                            }
+                            self.fetchAll(fetcher, batchSize: 2) { batches, error in
+                                XCTAssertNil(error, "Error fetching rows: \(String(describing: error))")
+                                XCTAssertEqual(batches.map { $0.count }, [2, 1], "Wrong batch sizes")
+
+                                // The statement of the result is closed, the titles are read from the fetcher's own copy
+                                connection.statementCacheSize = 0
+                                fetcher.fetchTitles { titles, error in
+                                    XCTAssertNil(error, "Error fetching titles: \(String(describing: error))")
+                                    XCTAssertEqual(titles ?? [], ["a", "b"], "Wrong column titles")
+
+                                    cleanUp(table: t.tableName, connection: connection) { _ in
+                                        expectation.fulfill()
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testCursorFetch() {
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    if let error = result.asError {
+                        XCTFail("Error in CREATE TABLE: \(error)")
+                        return
+                    }
+
+                    let rows: [[Any]] = (1...10).map { ["fruit\($0)", $0] }
+                    let i1 = Insert(into: t, rows: rows)
+                    executeQuery(query: i1, connection: connection) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+
+                        let s1 = Select(from: t).where(t.b > Parameter()).order(by: .ASC(t.b))
+                        connection.prepareStatement(s1) { result in
+                            guard let statement = result.asPreparedStatement as? MySQLPreparedStatement else {
+                                XCTFail("Unable to prepare statement: \(String(describing: result.asError))")
+                                return
+                            }
+                            statement.cursorPrefetchRows = 3
+
+                            connection.execute(preparedStatement: statement, parameters: [2]) { result in
+                                guard let resultSet = result.asResultSet else {
+                                    XCTFail("SELECT returned no result set: \(String(describing: result.asError))")
+                                    return
+                                }
+                                var values = [Int32]()
+                                resultSet.forEach() { row, error in
+                                    guard let row = row else {
+                                        XCTAssertNil(error, "Error fetching rows: \(String(describing: error))")
+                                        XCTAssertEqual(values, Array(3...10), "Wrong rows returned through the cursor")
+
+                                        connection.release(preparedStatement: statement) { _ in
+                                            cleanUp(table: t.tableName, connection: connection) { _ in
+                                                expectation.fulfill()
+                                            }
+                                        }
+                                        return
+                                    }
+                                    if let value = row[1] as? Int32 {
+                                        values.append(value)
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testLongValues() {
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        let short = "apple"
+        let long = String(repeating: "banana", count: 5000)
+        let blob = Data((0 ..< 100_000).map { UInt8(truncatingIfNeeded: $0) })
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: tableResultFetcher, connection: connection) { _ in
+                executeRawQuery("CREATE TABLE " + packName(tableResultFetcher) + " (a mediumtext, b longblob, c integer)", connection: connection) { result, rows in
+                    XCTAssertEqual(result.success, true, "CREATE TABLE failed")
+
+                    let insert = "INSERT INTO " + packName(tableResultFetcher) + " VALUES (?, ?, ?)"
+                    executeRawQueryWithParameters(insert, connection: connection, parameters: [short, blob, 1]) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+                        executeRawQueryWithParameters(insert, connection: connection, parameters: [long, nil, 2]) { result, rows in
+                            XCTAssertEqual(result.success, true, "INSERT failed")
+
+                            let select = "SELECT a, b, c FROM " + packName(tableResultFetcher) + " ORDER BY c"
+                            executeRawQuery(select, connection: connection) { result, rows in
+                                XCTAssertEqual(rows?.count, 2, "SELECT returned wrong number of rows")
+                                XCTAssertEqual(rows?[0][0] as? String, short, "Wrong short value")
+                                XCTAssertEqual(rows?[0][1] as? Data, blob, "Wrong blob value")
+                                XCTAssertEqual(rows?[1][0] as? String, long, "Wrong long value")
+                                XCTAssertNil(rows?[1][1] ?? nil, "Wrong NULL value")
+
+                                connection.fetch(select) { fetcher, error in
+                                    guard let fetcher = fetcher else {
+                                        XCTFail("No result fetcher returned: \(String(describing: error))")
+                                        return
+                                    }
+                                    var streamed = Data()
+                                    fetcher.stream(column: 1, chunkSize: 1000) { chunk in
+                                        streamed.append(chunk.bindMemory(to: UInt8.self))
+                                    }
+                                    self.fetchAll(fetcher, batchSize: 10) { batches, error in
+                                        XCTAssertNil(error, "Error fetching rows: \(String(describing: error))")
+                                        XCTAssertEqual(batches.first?[0][1] as? Int, blob.count, "Wrong streamed length")
+                                        XCTAssertNil(batches.first?[1][1] ?? nil, "Wrong streamed NULL value")
+                                        XCTAssertEqual(streamed, blob, "Wrong streamed value")
+
+                                        cleanUp(table: tableResultFetcher, connection: connection) { _ in
+                                            expectation.fulfill()
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testFetchColumns() {
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    if let error = result.asError {
+                        XCTFail("Error in CREATE TABLE: \(error)")
+                        return
+                    }
+
+                    let rows: [[Any?]] = [["apple", 1], [nil, 2], ["cherry", 3]]
+                    let i1 = Insert(into: t, rows: rows)
+                    executeQuery(query: i1, connection: connection) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+
+                        let s1 = Select(from: t).order(by: .ASC(t.b))
+                        connection.fetch(query: s1) { fetcher, error in
+                            guard let fetcher = fetcher else {
+                                XCTFail("No result fetcher returned: \(String(describing: error))")
+                                return
+                            }
+                            fetcher.fetchColumns(batchSize: 2) { batch, error in
+                                guard let batch = batch else {
+                                    XCTFail("No rows returned: \(String(describing: error))")
+                                    return
+                                }
+                                XCTAssertEqual(batch.rowCount, 2, "Wrong number of rows in first batch")
+                                XCTAssertEqual(batch.columns[0].string(at: 0), "apple", "Wrong value in row 0 column 0")
+                                XCTAssertTrue(batch.columns[0].isNull(1), "Wrong NULL value in row 1 column 0")
+                                XCTAssertEqual(batch.columns[1].integers, [1, 2], "Wrong values in column 1")
+
+                                fetcher.fetchColumns(batchSize: 2, reusing: batch) { batch, error in
+                                    XCTAssertEqual(batch?.rowCount, 1, "Wrong number of rows in second batch")
+                                    XCTAssertEqual(batch?.columns[0].string(at: 0), "cherry", "Wrong value in reused batch")
+                                    XCTAssertEqual(batch?.columns[1].integer(at: 0), 3, "Wrong value in reused batch")
+
+                                    fetcher.fetchColumns(batchSize: 2) { batch, error in
+                                        XCTAssertNil(batch, "Rows returned after the end of the result")
+
+                                        // Buffered DECIMAL values are decoded before they are written as text
+                                        self.fetchDecimalColumns(connection: connection, decimals: .decimal) {
+                                            self.fetchDecimalColumns(connection: connection, decimals: .scaledInteger) {
+                                                cleanUp(table: t.tableName, connection: connection) { _ in
+                                                    expectation.fulfill()
+                                                }
+                                            }
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testFetchColumnsBuffered() {
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.resultBuffering = .buffered
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    if let error = result.asError {
+                        XCTFail("Error in CREATE TABLE: \(error)")
+                        return
+                    }
+
+                    let rows: [[Any?]] = [["apple", 1], [nil, 2], ["cherry", 3]]
+                    let i1 = Insert(into: t, rows: rows)
+                    executeQuery(query: i1, connection: connection) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+
+                        // The binds of a buffered result are released before its columns are fetched
+                        let s1 = Select(from: t).order(by: .ASC(t.b))
+                        connection.fetch(query: s1) { fetcher, error in
+                            guard let fetcher = fetcher else {
+                                XCTFail("No result fetcher returned: \(String(describing: error))")
+                                return
+                            }
+                            fetcher.fetchColumns(batchSize: 2) { batch, error in
+                                guard let batch = batch else {
+                                    XCTFail("No rows returned: \(String(describing: error))")
+                                    return
+                                }
+                                XCTAssertEqual(batch.columns.count, 2, "Wrong number of columns")
+                                XCTAssertEqual(batch.rowCount, 2, "Wrong number of rows in first batch")
+                                XCTAssertEqual(batch.columns[0].string(at: 0), "apple", "Wrong value in row 0 column 0")
+                                XCTAssertTrue(batch.columns[0].isNull(1), "Wrong NULL value in row 1 column 0")
+                                XCTAssertEqual(batch.columns[1].integers, [1, 2], "Wrong values in column 1")
+
+                                fetcher.fetchColumns(batchSize: 2, reusing: batch) { batch, error in
+                                    XCTAssertEqual(batch?.rowCount, 1, "Wrong number of rows in second batch")
+                                    XCTAssertEqual(batch?.columns[0].string(at: 0), "cherry", "Wrong value in reused batch")
+
+                                    fetcher.fetchColumns(batchSize: 2) { batch, error in
+                                        XCTAssertNil(batch, "Rows returned after the end of the result")
+
+                                        cleanUp(table: t.tableName, connection: connection) { _ in
+                                            expectation.fulfill()
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func fetchDecimalColumns(connection: MySQLConnection, decimals: MySQLDecimalDecoding, onCompletion: @escaping () -> ()) {
+        connection.typeOptions = MySQLTypeOptions(decimals: decimals)
+        connection.fetch("SELECT CAST(12.34 AS DECIMAL(10,2)), CAST(-0.05 AS DECIMAL(10,2))") { fetcher, error in
+            guard let fetcher = fetcher else {
+                XCTFail("No result fetcher returned: \(String(describing: error))")
+                return onCompletion()
+            }
+            fetcher.fetchColumns(batchSize: 10) { batch, error in
+                XCTAssertEqual(batch?.columns[0].string(at: 0), "12.34", "Wrong DECIMAL value in column batch")
+                XCTAssertEqual(batch?.columns[1].string(at: 0), "-0.05", "Wrong negative DECIMAL value in column batch")
+                fetcher.done()
+                connection.typeOptions = MySQLTypeOptions()
+                onCompletion()
+            }
+        }
+    }
+
+    func testTypeOptions() {
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.typeOptions = MySQLTypeOptions(timeZone: TimeZone(identifier: "UTC")!, dateAndTimeAsValueTypes: true)
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        // 2019-03-31 01:30:45 UTC
+        let date = Date(timeIntervalSince1970: 1_553_995_845)
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: tableResultFetcher, connection: connection) { _ in
+                executeRawQuery("CREATE TABLE " + packName(tableResultFetcher) + " (a datetime, b date, c time, d datetime(6))", connection: connection) { result, rows in
+                    XCTAssertEqual(result.success, true, "CREATE TABLE failed")
+
+                    let insert = "INSERT INTO " + packName(tableResultFetcher) + " VALUES (?, ?, ?, '1969-12-31 23:59:59.250000')"
+                    executeRawQueryWithParameters(insert, connection: connection, parameters: [date, MySQLDate(year: 2019, month: 3, day: 31), MySQLTime(hours: 100, minutes: 5, seconds: 9)]) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+
+                        executeRawQuery("SELECT a, b, c, d, CAST(a AS CHAR) FROM " + packName(tableResultFetcher), connection: connection) { result, rows in
+                            XCTAssertEqual(rows?.count, 1, "SELECT returned wrong number of rows")
+                            XCTAssertEqual(rows?[0][0] as? Date, date, "Wrong DATETIME value")
+                            XCTAssertEqual(rows?[0][1] as? MySQLDate, MySQLDate(year: 2019, month: 3, day: 31), "Wrong DATE value")
+                            XCTAssertEqual(rows?[0][2] as? MySQLTime, MySQLTime(hours: 100, minutes: 5, seconds: 9), "Wrong TIME value")
+                            XCTAssertEqual(rows?[0][3] as? Date, Date(timeIntervalSince1970: -0.75), "Wrong fractional DATETIME value")
+                            XCTAssertEqual(rows?[0][4] as? String, "2019-03-31 01:30:45", "DATETIME not bound in the configured time zone")
+
+                            cleanUp(table: tableResultFetcher, connection: connection) { _ in
+                                expectation.fulfill()
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testRowBatches() {
+        #if swift(>=5.5)
+        #if canImport(_Concurrency)
+        guard #available(macOS 10.15, *) else {
+            return
+        }
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    if let error = result.asError {
+                        XCTFail("Error in CREATE TABLE: \(error)")
+                        return
+                    }
+
+                    let rows: [[Any]] = (1...100).map { ["fruit\($0)", $0] }
+                    let i1 = Insert(into: t, rows: rows)
+                    executeQuery(query: i1, connection: connection) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+
+                        Task {
+                            do {
+                                let s1 = Select(from: t).order(by: .ASC(t.b))
+                                guard let fetcher = try await connection.fetch(query: s1) else {
+                                    return XCTFail("No result fetcher returned")
+                                }
+                                var sizes = [Int]()
+                                var last: Int32? = nil
+                                for try await batch in fetcher.batches(ofSize: 30, prefetch: 2) {
+                                    sizes.append(batch.count)
+                                    last = batch.last?[1] as? Int32
+                                }
+                                XCTAssertEqual(sizes, [30, 30, 30, 10], "Wrong batch sizes")
+                                XCTAssertEqual(last, 100, "Wrong value in last row")
+
+                                // Leaving the loop early cancels the fetch of the remaining rows
+                                guard let partial = try await connection.fetch(query: s1) else {
+                                    return XCTFail("No result fetcher returned")
+                                }
+                                var first: [[Any?]]? = nil
+                                for try await batch in partial.batches(ofSize: 10) {
+                                    first = batch
+                                    break
+                                }
+                                XCTAssertEqual(first?.count, 10, "Wrong size of the first batch")
+
+                                let result = await connection.execute("SELECT COUNT(*) FROM " + packName(t.tableName))
+                                XCTAssertNil(result.asError, "Query after a cancelled fetch failed: \(String(describing: result.asError))")
+                            } catch {
+                                XCTFail("Error fetching batches: \(error)")
+                            }
+
+                            cleanUp(table: t.tableName, connection: connection) { _ in
+                                expectation.fulfill()
+                            }
+                        }
+                    }
+                }
+            }
+        })
+        #endif
+        #endif
+    }
+
+    func testDecimals() {
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.typeOptions = MySQLTypeOptions(decimals: .decimal)
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        let amount = Decimal(string: "-1234567.89", locale: Locale(identifier: "en_US_POSIX"))!
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: tableResultFetcher, connection: connection) { _ in
+                executeRawQuery("CREATE TABLE " + packName(tableResultFetcher) + " (a decimal(12,2), b decimal(40,10), c decimal(5,0))", connection: connection) { result, rows in
+                    XCTAssertEqual(result.success, true, "CREATE TABLE failed")
+
+                    let insert = "INSERT INTO " + packName(tableResultFetcher) + " VALUES (?, '123456789012345678901234567890.0123456789', 5)"
+                    executeRawQueryWithParameters(insert, connection: connection, parameters: [amount]) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT with a Decimal parameter failed")
+
+                        let select = "SELECT a, b, c FROM " + packName(tableResultFetcher) + " WHERE a = ?"
+                        executeRawQueryWithParameters(select, connection: connection, parameters: [amount]) { result, rows in
+                            XCTAssertEqual(rows?.count, 1, "SELECT returned wrong number of rows")
+                            XCTAssertEqual(rows?[0][0] as? Decimal, amount, "Wrong DECIMAL value")
+                            XCTAssertEqual(rows?[0][1] as? Decimal, Decimal(string: "123456789012345678901234567890.0123456789", locale: Locale(identifier: "en_US_POSIX")), "Wrong long DECIMAL value")
+                            XCTAssertEqual(rows?[0][2] as? Decimal, 5, "Wrong DECIMAL value without decimals")
+
+                            connection.typeOptions = MySQLTypeOptions(decimals: .scaledInteger)
+                            executeRawQueryWithParameters(select, connection: connection, parameters: [amount]) { result, rows in
+                                XCTAssertEqual(rows?[0][0] as? Int64, -123456789, "Wrong scaled DECIMAL value")
+                                XCTAssertNotNil(rows?[0][1] as? Decimal, "DECIMAL value too long for an Int64 not returned as Decimal")
+                                XCTAssertEqual(rows?[0][2] as? Int64, 5, "Wrong scaled DECIMAL value without decimals")
+
+                                cleanUp(table: tableResultFetcher, connection: connection) { _ in
+                                    expectation.fulfill()
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testMemoryBudget() {
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        let long = String(repeating: "banana", count: 50_000)
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: tableResultFetcher, connection: connection) { _ in
+                executeRawQuery("CREATE TABLE " + packName(tableResultFetcher) + " (a mediumtext, c integer)", connection: connection) { result, rows in
+                    XCTAssertEqual(result.success, true, "CREATE TABLE failed")
+
+                    let insert = "INSERT INTO " + packName(tableResultFetcher) + " VALUES (?, ?)"
+                    executeRawQueryWithParameters(insert, connection: connection, parameters: [long, 1]) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+
+                        let select = "SELECT a, c FROM " + packName(tableResultFetcher)
+                        connection.memoryBudget = MySQLMemoryBudget(limit: 64 * 1024, policy: .fail)
+                        connection.fetch(select) { fetcher, error in
+                            guard let fetcher = fetcher else {
+                                XCTFail("No result fetcher returned: \(String(describing: error))")
+                                return
+                            }
+                            self.fetchAll(fetcher, batchSize: 10) { batches, error in
+                                XCTAssertNotNil(error, "Value larger than the memory limit was fetched")
+                                XCTAssertTrue(batches.isEmpty, "Rows returned for a value larger than the memory limit")
+
+                                let budget = MySQLMemoryBudget(limit: 16 * 1024 * 1024)
+                                connection.memoryBudget = budget
+                                executeRawQuery(select, connection: connection) { result, rows in
+                                    XCTAssertEqual(rows?[0][0] as? String, long, "Wrong long value")
+                                    XCTAssertGreaterThanOrEqual(connection.peakMemoryInUse, long.utf8.count, "Long value not counted")
+                                    XCTAssertGreaterThanOrEqual(budget.peak, long.utf8.count, "Long value not counted by the budget")
+                                    XCTAssertLessThan(budget.current, long.utf8.count, "Memory of the long value not released")
+
+                                    cleanUp(table: tableResultFetcher, connection: connection) { _ in
+                                        expectation.fulfill()
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+}
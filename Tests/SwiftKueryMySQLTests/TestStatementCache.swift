@@ -0,0 +1,327 @@
+/**
+ Copyright IBM Corporation 2019
+
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+
+ http://www.apache.org/licenses/LICENSE-2.0
+
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+ */
+
+import XCTest
+import Foundation
+import SwiftKuery
+import SwiftKueryMySQL
+
+#if os(Linux)
+let tableStatementCache = "tableStatementCacheLinux"
+#else
+let tableStatementCache = "tableStatementCacheOSX"
+#endif
+
+class TestStatementCache: XCTestCase {
+
+    static var allTests: [(String, (TestStatementCache) -> () throws -> Void)] {
+        return [
+            ("testStatementCache", testStatementCache),
+            ("testQueryStringCache", testQueryStringCache),
+            ("testResultBindReuse", testResultBindReuse),
+            ("testCachedResultMetadata", testCachedResultMetadata),
+            ("testResultCache", testResultCache),
+        ]
+    }
+
+    class MyTable : Table {
+        let a = Column("a", Varchar.self, length: 10)
+        let b = Column("b", Int32.self)
+
+        let tableName = tableStatementCache
+    }
+
+    func testStatementCache() {
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.statementCacheSize = 2
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    if let error = result.asError {
+                        XCTFail("Error in CREATE TABLE: \(error)")
+                        return
+                    }
+
+                    let i1 = Insert(into: t, values: Parameter(), Parameter())
+                    executeQueryWithParameters(query: i1, connection: connection, parameters: ["apple", 1]) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+                        executeQueryWithParameters(query: i1, connection: connection, parameters: ["banana", 2]) { result, rows in
+                            XCTAssertEqual(result.success, true, "INSERT failed")
+
+                            let s1 = Select(from: t).where(t.b > Parameter())
+                            executeQueryWithParameters(query: s1, connection: connection, parameters: [0]) { result, rows in
+                                XCTAssertEqual(rows?.count, 2, "SELECT returned wrong number of rows: \(String(describing: rows?.count)) instead of 2")
+                                executeQueryWithParameters(query: s1, connection: connection, parameters: [1]) { result, rows in
+                                    XCTAssertEqual(rows?.count, 1, "SELECT returned wrong number of rows: \(String(describing: rows?.count)) instead of 1")
+                                    XCTAssertEqual(rows?[0][0] as? String, "banana", "Wrong value in row 0 column 0: \(String(describing: rows?[0][0])) instead of 'banana'")
+
+                                    XCTAssertEqual(connection.statementCacheHits, 2, "Wrong number of statement cache hits")
+
+                                    connection.statementCacheSize = 0
+                                    executeQueryWithParameters(query: s1, connection: connection, parameters: [0]) { result, rows in
+                                        XCTAssertEqual(rows?.count, 2, "SELECT returned wrong number of rows: \(String(describing: rows?.count)) instead of 2")
+                                        XCTAssertEqual(connection.statementCacheHits, 2, "Statement cache used while disabled")
+
+                                        cleanUp(table: t.tableName, connection: connection) { _ in
+                                            expectation.fulfill()
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testQueryStringCache() {
+        let cache = MySQLQueryStringCache(capacity: 2)
+        var builds = 0
+        let build = { () -> String in
+            builds += 1
+            return "SELECT \(builds)"
+        }
+        XCTAssertEqual(cache.sql(for: "a", build: build), "SELECT 1", "Wrong SQL built")
+        XCTAssertEqual(cache.sql(for: "a", build: build), "SELECT 1", "SQL not taken from the cache")
+        XCTAssertEqual(cache.sql(for: "b", build: build), "SELECT 2", "Wrong SQL built")
+        XCTAssertEqual(cache.sql(for: "a", build: build), "SELECT 1", "SQL not taken from the cache")
+        // The least recently used key is evicted
+        XCTAssertEqual(cache.sql(for: "c", build: build), "SELECT 3", "Wrong SQL built")
+        XCTAssertEqual(cache.sql(for: "b", build: build), "SELECT 4", "Evicted SQL taken from the cache")
+        XCTAssertEqual(builds, 4, "Wrong number of builds")
+
+        let t = MyTable()
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.statementCacheSize = 2
+        connection.queryStringCache = cache
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    XCTAssertNil(result.asError, "Error in CREATE TABLE: \(result.asError!)")
+                    let insert = Insert(into: t, values: Parameter(), Parameter())
+                    connection.execute(query: insert, cacheKey: "insert", parameters: ["apple", 1]) { result in
+                        XCTAssertNil(result.asError, "Error in INSERT: \(result.asError!)")
+                        connection.execute(query: insert, cacheKey: "insert", parameters: ["banana", 2]) { result in
+                            XCTAssertNil(result.asError, "Error in INSERT: \(result.asError!)")
+                            XCTAssertEqual(connection.statementCacheHits, 1, "Cached statement not reused")
+                            executeQuery(query: Select(from: t), connection: connection) { result, rows in
+                                XCTAssertEqual(rows?.count, 2, "Wrong number of rows inserted")
+                                cleanUp(table: t.tableName, connection: connection) { _ in
+                                    expectation.fulfill()
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testResultBindReuse() {
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.statementCacheSize = 2
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        // Longer than the initial buffer of a TEXT column, so that the buffer of the column is grown
+        let long = String(repeating: "abcdefgh", count: 1024)
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                executeRawQuery("CREATE TABLE " + packName(t.tableName) + " (a text, b integer)", connection: connection) { result, rows in
+                    XCTAssertNil(result.asError, "Error in CREATE TABLE: \(result.asError!)")
+
+                    let i1 = Insert(into: t, values: Parameter(), Parameter())
+                    executeQueryWithParameters(query: i1, connection: connection, parameters: [long, 1]) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+                        executeQueryWithParameters(query: i1, connection: connection, parameters: ["banana", 2]) { result, rows in
+                            XCTAssertEqual(result.success, true, "INSERT failed")
+
+                            // Each execution of the cached statement reuses the binds of the previous result
+                            let s1 = Select(t.a, from: t).where(t.b == Parameter())
+                            executeQueryWithParameters(query: s1, connection: connection, parameters: [1]) { result, rows in
+                                XCTAssertEqual(rows?.first?.first as? String, long, "Wrong value of a grown column")
+                                executeQueryWithParameters(query: s1, connection: connection, parameters: [2]) { result, rows in
+                                    XCTAssertEqual(rows?.first?.first as? String, "banana", "Wrong value in a reused bind")
+                                    executeQueryWithParameters(query: s1, connection: connection, parameters: [1]) { result, rows in
+                                        XCTAssertEqual(rows?.first?.first as? String, long, "Wrong value of a grown column")
+                                        XCTAssertEqual(connection.statementCacheHits, 3, "Cached statements not reused")
+
+                                        cleanUp(table: t.tableName, connection: connection) { _ in
+                                            expectation.fulfill()
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testCachedResultMetadata() {
+        let t = MyTable()
+
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.statementCacheSize = 2
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        let select = "SELECT * FROM " + packName(t.tableName) + " WHERE b = ?"
+        let query = { (callback: @escaping ([String]?, [Any?]?) -> ()) in
+            connection.execute(select, parameters: [1]) { result in
+                guard let resultSet = result.asResultSet else {
+                    XCTFail("SELECT failed: \(String(describing: result.asError))")
+                    return callback(nil, nil)
+                }
+                resultSet.getColumnTitles { titles, error in
+                    resultSet.nextRow { row, error in
+                        resultSet.done()
+                        callback(titles, row)
+                    }
+                }
+            }
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    if let error = result.asError {
+                        XCTFail("Error in CREATE TABLE: \(error)")
+                        return
+                    }
+
+                    let i1 = Insert(into: t, values: "apple", 1)
+                    executeQuery(query: i1, connection: connection) { result, rows in
+                        XCTAssertEqual(result.success, true, "INSERT failed")
+
+                        query { titles, row in
+                            XCTAssertEqual(titles ?? [], ["a", "b"], "Wrong column titles")
+                            XCTAssertEqual(row?.first as? String, "apple", "Wrong value in column a")
+                            // The second execution uses the columns read by the first one
+                            query { titles, row in
+                                XCTAssertEqual(titles ?? [], ["a", "b"], "Wrong cached column titles")
+                                XCTAssertEqual(row?.first as? String, "apple", "Wrong value in column a")
+                                XCTAssertEqual(row?.last as? Int32, 1, "Wrong value in column b")
+                                XCTAssertEqual(connection.statementCacheHits, 1, "Cached statement not reused")
+
+                                // The server re-prepares the statement with the new column, whose metadata replaces the cached one
+                                executeRawQuery("ALTER TABLE " + packName(t.tableName) + " ADD COLUMN c integer DEFAULT 7", connection: connection) { result, rows in
+                                    XCTAssertNil(result.asError, "Error in ALTER TABLE: \(result.asError!)")
+                                    query { titles, row in
+                                        XCTAssertEqual(titles ?? [], ["a", "b", "c"], "Column titles not refreshed")
+                                        XCTAssertEqual(row?.count, 3, "Wrong number of columns")
+                                        XCTAssertEqual(row?.last as? Int32, 7, "Wrong value in column c")
+
+                                        cleanUp(table: t.tableName, connection: connection) { _ in
+                                            expectation.fulfill()
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testResultCache() {
+        let t = MyTable()
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        let cache = MySQLResultCache(timeToLive: 60)
+        connection.resultCache = cache
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        let select = Select(from: t).where(t.b < Parameter())
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                t.create(connection: connection) { result in
+                    XCTAssertNil(result.asError, "Error in CREATE TABLE: \(result.asError!)")
+                    executeQuery(query: Insert(into: t, values: "apple", 1), connection: connection) { result, _ in
+                        XCTAssertNil(result.asError, "Error in INSERT: \(result.asError!)")
+                        executeQueryWithParameters(query: select, connection: connection, parameters: [10]) { result, rows in
+                            XCTAssertEqual(rows?.count, 1, "Wrong number of rows selected")
+                            XCTAssertEqual(cache.misses, 1, "Select not counted as a miss")
+
+                            // A raw insert does not invalidate the cache
+                            executeRawQuery("INSERT INTO " + packName(t.tableName) + " VALUES ('banana', 2)", connection: connection) { result, _ in
+                                XCTAssertNil(result.asError, "Error in INSERT: \(result.asError!)")
+                                executeQueryWithParameters(query: select, connection: connection, parameters: [10]) { result, rows in
+                                    XCTAssertEqual(rows?.count, 1, "Rows not returned from the cache")
+                                    XCTAssertEqual(rows?.first?[0] as? String, "apple", "Wrong value returned from the cache")
+                                    XCTAssertEqual(cache.hits, 1, "Select not counted as a hit")
+
+                                    executeQueryWithParameters(query: select, connection: connection, parameters: [2]) { result, rows in
+                                        XCTAssertEqual(rows?.count, 1, "Cached rows returned for other parameters")
+
+                                        executeQuery(query: Insert(into: t, values: "cherry", 3), connection: connection) { result, _ in
+                                            XCTAssertNil(result.asError, "Error in INSERT: \(result.asError!)")
+                                            executeQueryWithParameters(query: select, connection: connection, parameters: [10]) { result, rows in
+                                                XCTAssertEqual(rows?.count, 3, "Cached rows not invalidated by an insert")
+                                                XCTAssertEqual(cache.hits, 1, "Wrong number of hits")
+                                                XCTAssertEqual(cache.misses, 3, "Wrong number of misses")
+
+                                                cache.removeAll()
+                                                XCTAssertEqual(cache.size, 0, "Cache not emptied")
+                                                cleanUp(table: t.tableName, connection: connection) { _ in
+                                                    expectation.fulfill()
+                                                }
+                                            }
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+}
@@ -31,6 +31,8 @@ class TestTransaction: XCTestCase {
             ("testRollback", testRollback),
             ("testSavepoint", testSavepoint),
             ("testTransaction", testTransaction),
+            ("testDeferredTransaction", testDeferredTransaction),
+            ("testWithTransaction", testWithTransaction),
         ]
     }
 
@@ -400,4 +402,96 @@ class TestTransaction: XCTestCase {
             }
         })
     }
+
+    func testDeferredTransaction() {
+        let t = MyTable()
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        connection.transactionMode = .deferred
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                executeRawQuery("CREATE TABLE " +  packName(t.tableName) + " (a varchar(40), b integer)", connection: connection) { result, rows in
+                    XCTAssertNil(result.asError, "Error in CREATE TABLE: \(result.asError!)")
+
+                    // A transaction without statements is not sent to the server
+                    connection.startTransaction() { result in
+                        XCTAssertNil(result.asError, "Error in start transaction: \(result.asError!)")
+                        connection.commit() { result in
+                            XCTAssertNil(result.asError, "Error in commit transaction: \(result.asError!)")
+
+                            connection.startTransaction() { result in
+                                XCTAssertNil(result.asError, "Error in start transaction: \(result.asError!)")
+                                let i1 = Insert(into: t, rows: [["apple", 10], ["apricot", 3]])
+                                executeQuery(query: i1, connection: connection) { result, rows in
+                                    XCTAssertNil(result.asError, "Error in INSERT: \(result.asError!)")
+
+                                    connection.rollback() { result in
+                                        XCTAssertNil(result.asError, "Error in rollback transaction: \(result.asError!)")
+                                        executeQuery(query: Select(from: t), connection: connection) { result, rows in
+                                            XCTAssertEqual(rows?.count ?? 0, 0, "Rows inserted in a deferred transaction not rolled back")
+                                            cleanUp(table: t.tableName, connection: connection) { _ in
+                                                expectation.fulfill()
+                                            }
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
+
+    func testWithTransaction() {
+        struct Abort: Error {}
+
+        let t = MyTable()
+        guard let connection = CommonUtils.sharedInstance.getConnection() else {
+            return
+        }
+        XCTAssertEqual(connection.connectSync().success, true, "Failed to connect")
+        defer {
+            connection.closeConnection()
+        }
+
+        performTest(asyncTasks: { expectation in
+            cleanUp(table: t.tableName, connection: connection) { _ in
+                executeRawQuery("CREATE TABLE " +  packName(t.tableName) + " (a varchar(40), b integer)", connection: connection) { result, rows in
+                    XCTAssertNil(result.asError, "Error in CREATE TABLE: \(result.asError!)")
+
+                    connection.withTransaction({ transaction in
+                        let inserted = try transaction.execute(query: Insert(into: t, rows: [["apple", 10], ["apricot", 3]]))
+                        XCTAssertEqual(inserted.affectedRows, 2, "Wrong number of rows inserted")
+                        try transaction.execute(query: Update(t, set: [(t.b, Parameter())], where: t.a == "apple"), parameters: [11])
+                        let selected = try transaction.execute(query: Select(t.b, from: t).where(t.a == "apple"))
+                        XCTAssertEqual(selected.rows.count, 1, "Wrong number of rows selected in the transaction")
+                        XCTAssertEqual(selected.titles, ["b"], "Wrong titles")
+                    }) { result in
+                        XCTAssertNil(result.asError, "Error in transaction: \(result.asError!)")
+
+                        connection.withTransaction({ transaction in
+                            try transaction.execute(query: Insert(into: t, rows: [["banana", 1]]))
+                            throw Abort()
+                        }) { result in
+                            XCTAssertTrue(result.asError is Abort, "Error of the transaction body not returned")
+
+                            executeQuery(query: Select(from: t), connection: connection) { result, rows in
+                                XCTAssertEqual(rows?.count, 2, "Wrong number of rows committed")
+                                cleanUp(table: t.tableName, connection: connection) { _ in
+                                    expectation.fulfill()
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        })
+    }
 }